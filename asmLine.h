@@ -0,0 +1,27 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Structure for a single line of generated .asm.
+ * Code generation fills a list of these so it can be
+ * optimized before anything is written to the file.
+ * Each line keeps the source line it was generated for,
+ * which optimization carries along when it rewrites lines.
+ */
+
+#ifndef ASMLINE_H
+#define ASMLINE_H
+
+#include <string>
+
+struct asmLine
+{
+  std::string label;	// Label on the line, empty for none
+  std::string op;	// Instruction name such as LOAD or BRZERO
+  std::string arg;	// Variable, integer, or label, empty for none
+  int line;		// Source line of the statement, 0 if unknown
+
+  asmLine() : line(0) {}
+};
+
+#endif
@@ -0,0 +1,18 @@
+lbl: NOOP
+LOAD lbl
+SUB 5
+BRNEG L0
+BRPOS L0
+LOAD 1
+STORE T0
+WRITE T0
+LOAD 6
+STORE lbl
+BR lbl
+L0: NOOP
+LOAD 2
+STORE T0
+WRITE T0
+STOP
+T0 0
+lbl 5
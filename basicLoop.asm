@@ -0,0 +1,17 @@
+LOAD 1
+STORE x
+WRITE x
+LOAD 2
+STORE x
+WRITE x
+LOAD 3
+STORE x
+WRITE x
+LOAD 4
+STORE x
+WRITE x
+LOAD 5
+STORE x
+WRITE x
+STOP
+x 0
@@ -0,0 +1,32 @@
+LOAD 1
+STORE T0
+WRITE T0
+LOAD 2
+STORE T0
+WRITE T0
+LOAD 3
+STORE T0
+WRITE T0
+LOAD 4
+STORE T0
+WRITE T0
+LOAD 5
+STORE T0
+WRITE T0
+LOAD 6
+STORE T0
+WRITE T0
+LOAD 7
+STORE T0
+WRITE T0
+LOAD 8
+STORE T0
+WRITE T0
+LOAD 9
+STORE T0
+WRITE T0
+LOAD 10
+STORE T0
+WRITE T0
+STOP
+T0 0
@@ -0,0 +1,248 @@
+# Generated by comp --target=x86_64
+	.text
+	.globl _start
+_start:
+	xorl %eax, %eax
+					# LOAD 1
+	movl $1, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# LOAD 2
+	movl $2, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# LOAD 3
+	movl $3, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# LOAD 4
+	movl $4, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# LOAD 5
+	movl $5, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# LOAD 6
+	movl $6, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# LOAD 7
+	movl $7, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# LOAD 8
+	movl $8, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# LOAD 9
+	movl $9, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# LOAD 10
+	movl $10, %eax
+					# STORE T0
+	movl %eax, v_T0(%rip)
+					# WRITE T0
+	movl v_T0(%rip), %edi
+	call sp_write
+					# STOP
+	jmp sp_stop
+	jmp sp_stop
+
+	.data
+	.balign 4
+v_T0:	.long 0
+
+# Runtime for READ and WRITE through Linux system calls.
+	.text
+sp_stop:
+	call sp_flush
+	movl $60, %eax			# exit(0)
+	xorl %edi, %edi
+	syscall
+
+sp_input:
+	leaq sp_input_msg(%rip), %rsi
+	movl $sp_input_end - sp_input_msg, %edx
+	jmp sp_fail
+
+sp_divide:
+	leaq sp_divide_msg(%rip), %rsi
+	movl $sp_divide_end - sp_divide_msg, %edx
+
+sp_fail:				# message in rsi, length in edx
+	pushq %rsi
+	pushq %rdx
+	call sp_flush
+	popq %rdx
+	popq %rsi
+	movl $1, %eax			# write(1, message, length)
+	movl $1, %edi
+	syscall
+	movl $60, %eax			# exit(1)
+	movl $1, %edi
+	syscall
+
+sp_read:				# reads an integer into (rdi)
+	pushq %rax
+	pushq %rbx
+	pushq %r12
+	movq %rdi, %rbx
+	call sp_flush
+1:	call sp_peek			# skip white space
+	cmpl $32, %eax
+	je 2f
+	leal -9(%rax), %ecx		# \t through \r
+	cmpl $4, %ecx
+	ja 3f
+2:	incl sp_in_pos(%rip)
+	jmp 1b
+3:	xorl %r12d, %r12d		# 1 when negative
+	cmpl $43, %eax			# '+'
+	je 4f
+	cmpl $45, %eax			# '-'
+	jne 5f
+	incl %r12d
+4:	incl sp_in_pos(%rip)
+	call sp_peek
+5:	leal -48(%rax), %ecx		# at least one digit is needed
+	cmpl $9, %ecx
+	ja sp_input
+	movl $0, (%rbx)
+6:	imull $10, (%rbx), %edx
+	addl %ecx, %edx
+	movl %edx, (%rbx)
+	incl sp_in_pos(%rip)
+	call sp_peek
+	leal -48(%rax), %ecx
+	cmpl $9, %ecx
+	jbe 6b
+	testl %r12d, %r12d
+	jz 7f
+	negl (%rbx)
+7:	popq %r12
+	popq %rbx
+	popq %rax
+	ret
+
+sp_peek:				# next input byte in eax, -1 at the end
+	movl sp_in_pos(%rip), %ecx
+	cmpl sp_in_len(%rip), %ecx
+	jb 1f
+	xorl %eax, %eax			# read(0, sp_in_buf, 4096)
+	xorl %edi, %edi
+	leaq sp_in_buf(%rip), %rsi
+	movl $4096, %edx
+	syscall
+	testq %rax, %rax
+	jle 2f
+	movl %eax, sp_in_len(%rip)
+	xorl %ecx, %ecx
+	movl %ecx, sp_in_pos(%rip)
+1:	leaq sp_in_buf(%rip), %rdx
+	movzbl (%rdx,%rcx), %eax
+	ret
+2:	movl $-1, %eax
+	ret
+
+sp_write:				# writes edi and a newline
+	pushq %rax
+	pushq %rdi
+	cmpl $4084, sp_out_len(%rip)	# room for 12 more bytes
+	jbe 1f
+	call sp_flush
+1:	popq %rdi
+	subq $16, %rsp			# digits go backwards from the top
+	leaq 15(%rsp), %rsi
+	movb $10, (%rsi)
+	movl %edi, %eax
+	testl %eax, %eax
+	jns 2f
+	negl %eax			# the most negative value works unsigned
+2:	movl $10, %ecx
+3:	xorl %edx, %edx
+	divl %ecx
+	addl $48, %edx
+	decq %rsi
+	movb %dl, (%rsi)
+	testl %eax, %eax
+	jnz 3b
+	testl %edi, %edi
+	jns 4f
+	decq %rsi
+	movb $45, (%rsi)
+4:	leaq 16(%rsp), %rcx
+	subq %rsi, %rcx
+	movl sp_out_len(%rip), %edx
+	leaq sp_out_buf(%rip), %rdi
+	addq %rdx, %rdi
+	addl %ecx, sp_out_len(%rip)
+	rep movsb
+	addq $16, %rsp
+	popq %rax
+	ret
+
+sp_flush:				# writes out everything buffered
+	pushq %rbx
+	xorl %ebx, %ebx
+1:	movl sp_out_len(%rip), %edx
+	subl %ebx, %edx
+	jle 2f
+	movl $1, %eax			# write(1, sp_out_buf + done, left)
+	movl $1, %edi
+	leaq sp_out_buf(%rip), %rsi
+	addq %rbx, %rsi
+	syscall
+	testq %rax, %rax
+	jle 2f				# output was closed
+	addl %eax, %ebx
+	jmp 1b
+2:	movl $0, sp_out_len(%rip)
+	popq %rbx
+	ret
+
+	.section .rodata
+sp_input_msg:
+	.ascii "\nVM ERROR: Unable to read input for 'READ'.\n\n"
+sp_input_end:
+sp_divide_msg:
+	.ascii "\nVM ERROR: Division by zero 'DIV'.\n\n"
+sp_divide_end:
+
+	.bss
+	.balign 4
+sp_in_pos:	.space 4
+sp_in_len:	.space 4
+sp_out_len:	.space 4
+sp_in_buf:	.space 4096
+sp_out_buf:	.space 4096
+
+	.section .note.GNU-stack,"",@progbits
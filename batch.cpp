@@ -0,0 +1,354 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Batch mode for vmsim -b, running one program over many input
+ * records at once. Every line of the records file is one record,
+ * the integers its READs take in order. Each record writes one line
+ * of output, its WRITEs separated by spaces, in the order of the
+ * records file no matter which finished first.
+ *
+ * Eight records run side by side in the lanes of a laneGroup, with
+ * variables laid out so the same variable of every lane is one AVX2
+ * register. Each lane has its own pc, since conditions from genRO
+ * send lanes different ways. Every step issues the lowest pc of any
+ * lane for all lanes at that pc, masking out the rest, so lanes that
+ * split up wait for each other and run together again afterwards.
+ * A lane whose record stops takes the next record right away instead
+ * of idling until the whole group is done.
+ *
+ * LOAD, STORE, ADD, SUB, MULT, and branches run on all lanes at once
+ * in stepSimd. READ, WRITE, DIV, and STOP go lane by lane in stepLane.
+ * Hosts without AVX2 use stepScalar, which gives the same results.
+ */
+
+#include "batch.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <limits.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BATCH_AVX2
+#include <immintrin.h>
+#endif
+using namespace std;
+
+/* Reads a records file, one record per line. Empty lines are
+ * skipped. A record ends at anything that is not an integer, so
+ * a READ past it fails like running out of input.
+ */
+void loadRecords(istream &in, vector<vector<int> > &records)
+{
+  string line;
+  while(getline(in, line))
+  {
+    if(line.find_first_not_of(" \t\r") == string::npos)
+    {
+      continue;
+    }
+    stringstream values(line);
+    vector<int> record;
+    int value;
+    while(values >> value)
+    {
+      record.push_back(value);
+    }
+    records.push_back(record);
+  }
+}
+
+/* True if this host runs lane groups with AVX2.
+ */
+bool batchSimd()
+{
+#ifdef BATCH_AVX2
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+/* Runs every record through a program and writes one line for
+ * each. A record that fails gets its error at the end of its line.
+ */
+void runBatch(const program &prog, const vector<vector<int> > &records, ostream &out,
+              batchStats &stats)
+{
+  stats.records = records.size();
+  stats.steps = 0;
+  stats.lanes = 0;
+  stats.simd = batchSimd();
+  void (*step)(laneGroup &, const instr &, int) = stats.simd ? stepSimd : stepScalar;
+
+  laneGroup group;
+  group.data.assign((prog.data.size() + 1) * BATCH_LANES, 0);
+  int next = 0;
+  for(int l = 0; l < BATCH_LANES; l++)
+  {
+    startLane(group, prog, l, next < (int)records.size() ? next++ : -1);
+  }
+
+  // Finished lines wait here until every record before them is out.
+  vector<string> lines(records.size());
+  vector<bool> done(records.size(), false);
+  unsigned int printed = 0;
+
+  while(true)
+  {
+    int pc = INT_MAX;
+    for(int l = 0; l < BATCH_LANES; l++)
+    {
+      pc = group.pc[l] < pc ? group.pc[l] : pc;
+    }
+    if(pc == INT_MAX)
+    {
+      break;
+    }
+
+    const instr &cur = prog.code[pc];
+    stats.steps++;
+    if(cur.op == READ_op || cur.op == WRITE_op || cur.op == DIV_op || cur.op == STOP_op)
+    {
+      for(int l = 0; l < BATCH_LANES; l++)
+      {
+        string error;
+        if(group.pc[l] != pc)
+        {
+          continue;
+        }
+        stats.lanes++;
+        if(!stepLane(group, prog, records, l, error))
+        {
+          continue;
+        }
+        int record = group.record[l];
+        lines[record].swap(group.output[l]);
+        if(!error.empty() && !lines[record].empty())
+        {
+          lines[record] += ' ';
+        }
+        lines[record] += error;
+        done[record] = true;
+        startLane(group, prog, l, next < (int)records.size() ? next++ : -1);
+      }
+      while(printed < records.size() && done[printed])
+      {
+        out << lines[printed] << '\n';
+        string().swap(lines[printed]);
+        printed++;
+      }
+    }
+    else
+    {
+      for(int l = 0; l < BATCH_LANES; l++)
+      {
+        stats.lanes += group.pc[l] == pc;
+      }
+      step(group, cur, pc);
+    }
+  }
+  out.flush();
+}
+
+/* Starts a record in a lane with fresh variables, or leaves the
+ * lane idle when record is -1.
+ */
+void startLane(laneGroup &group, const program &prog, int lane, int record)
+{
+  group.record[lane] = record;
+  group.pc[lane] = record < 0 ? INT_MAX : 0;
+  group.acc[lane] = 0;
+  group.read[lane] = 0;
+  group.output[lane].clear();
+  for(unsigned int v = 0; v < prog.data.size(); v++)
+  {
+    group.data[v * BATCH_LANES + lane] = prog.data[v];
+  }
+}
+
+/* Executes the instruction at a lane's pc for that lane alone.
+ * Returns true when its record is over, with error set if it
+ * could not finish.
+ */
+bool stepLane(laneGroup &group, const program &prog, const vector<vector<int> > &records,
+              int lane, string &error)
+{
+  const instr &cur = prog.code[group.pc[lane]];
+  int &acc = group.acc[lane];
+  int value = cur.immediate || cur.op == STOP_op ? cur.arg
+              : group.data[cur.arg * BATCH_LANES + lane];
+  group.pc[lane]++;
+
+  switch(cur.op)
+  {
+  case READ_op:
+  {
+    const vector<int> &record = records[group.record[lane]];
+    if(group.read[lane] >= record.size())
+    {
+      error = "error: Unable to read input";
+      return true;
+    }
+    if(!cur.immediate)
+    {
+      group.data[cur.arg * BATCH_LANES + lane] = record[group.read[lane]];
+    }
+    group.read[lane]++;
+    return false;
+  }
+  case WRITE_op:
+  {
+    stringstream text;
+    text << (group.output[lane].empty() ? "" : " ") << value;
+    group.output[lane] += text.str();
+    return false;
+  }
+  case DIV_op:
+    if(value == 0)
+    {
+      error = "error: Division by zero";
+      return true;
+    }
+    acc /= value;
+    return false;
+  default:
+    return true;
+  }
+}
+
+/* Executes an instruction for every lane at pc, one lane at a time.
+ * Only LOAD, STORE, arithmetic but DIV, branches, and NOOP come here.
+ */
+void stepScalar(laneGroup &group, const instr &cur, int pc)
+{
+  for(int l = 0; l < BATCH_LANES; l++)
+  {
+    if(group.pc[l] != pc)
+    {
+      continue;
+    }
+    int &acc = group.acc[l];
+    int *slot = NULL;
+    if(cur.op < BR_op && !cur.immediate)
+    {
+      slot = &group.data[cur.arg * BATCH_LANES + l];
+    }
+    int value = cur.immediate ? cur.arg : slot ? *slot : 0;
+    bool taken = false;
+    switch(cur.op)
+    {
+    case LOAD_op:
+      acc = value;
+      break;
+    case STORE_op:
+      if(slot)
+      {
+        *slot = acc;
+      }
+      break;
+    case ADD_op:
+      acc += value;
+      break;
+    case SUB_op:
+      acc -= value;
+      break;
+    case MULT_op:
+      acc *= value;
+      break;
+    case BR_op:
+      taken = true;
+      break;
+    case BRNEG_op:
+      taken = acc < 0;
+      break;
+    case BRZNEG_op:
+      taken = acc <= 0;
+      break;
+    case BRPOS_op:
+      taken = acc > 0;
+      break;
+    case BRZPOS_op:
+      taken = acc >= 0;
+      break;
+    case BRZERO_op:
+      taken = acc == 0;
+      break;
+    default:
+      break;
+    }
+    group.pc[l] = taken ? cur.arg : pc + 1;
+  }
+}
+
+#ifdef BATCH_AVX2
+/* Executes an instruction for every lane at pc with AVX2. Lanes at
+ * other instructions are masked out of every result written back.
+ */
+__attribute__((target("avx2")))
+void stepSimd(laneGroup &group, const instr &cur, int pc)
+{
+  __m256i pcs = _mm256_loadu_si256((__m256i *)group.pc);
+  __m256i on = _mm256_cmpeq_epi32(pcs, _mm256_set1_epi32(pc));
+  __m256i acc = _mm256_loadu_si256((__m256i *)group.acc);
+  __m256i zero = _mm256_setzero_si256();
+  __m256i *slot = (__m256i *)&group.data[(cur.op < BR_op && !cur.immediate ? cur.arg : 0)
+                                          * BATCH_LANES];
+  __m256i value = cur.immediate ? _mm256_set1_epi32(cur.arg) : _mm256_loadu_si256(slot);
+  __m256i taken = zero;
+
+  switch(cur.op)
+  {
+  case LOAD_op:
+    acc = _mm256_blendv_epi8(acc, value, on);
+    break;
+  case STORE_op:
+    if(!cur.immediate)
+    {
+      _mm256_storeu_si256(slot, _mm256_blendv_epi8(value, acc, on));
+    }
+    break;
+  case ADD_op:
+    acc = _mm256_blendv_epi8(acc, _mm256_add_epi32(acc, value), on);
+    break;
+  case SUB_op:
+    acc = _mm256_blendv_epi8(acc, _mm256_sub_epi32(acc, value), on);
+    break;
+  case MULT_op:
+    acc = _mm256_blendv_epi8(acc, _mm256_mullo_epi32(acc, value), on);
+    break;
+  case BR_op:
+    taken = _mm256_set1_epi32(-1);
+    break;
+  case BRNEG_op:
+    taken = _mm256_cmpgt_epi32(zero, acc);
+    break;
+  case BRZNEG_op:
+    taken = _mm256_xor_si256(_mm256_cmpgt_epi32(acc, zero), _mm256_set1_epi32(-1));
+    break;
+  case BRPOS_op:
+    taken = _mm256_cmpgt_epi32(acc, zero);
+    break;
+  case BRZPOS_op:
+    taken = _mm256_xor_si256(_mm256_cmpgt_epi32(zero, acc), _mm256_set1_epi32(-1));
+    break;
+  case BRZERO_op:
+    taken = _mm256_cmpeq_epi32(acc, zero);
+    break;
+  default:
+    break;
+  }
+
+  __m256i next = _mm256_blendv_epi8(_mm256_set1_epi32(pc + 1),
+                                    _mm256_set1_epi32(cur.arg), taken);
+  _mm256_storeu_si256((__m256i *)group.acc, acc);
+  _mm256_storeu_si256((__m256i *)group.pc, _mm256_blendv_epi8(pcs, next, on));
+}
+#else
+/* Without AVX2 the lanes can only run one at a time.
+ */
+void stepSimd(laneGroup &group, const instr &cur, int pc)
+{
+  stepScalar(group, cur, pc);
+}
+#endif
@@ -0,0 +1,49 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for batch.cpp.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "virtMach.h"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Records run side by side, one per 32 bit lane of an AVX2 register.
+static const int BATCH_LANES = 8;
+
+struct laneGroup
+{
+  std::vector<int> data;	// Variable v of lane l at v * BATCH_LANES + l
+  int acc[BATCH_LANES];
+  int pc[BATCH_LANES];		// Next instruction, INT_MAX when the lane is idle
+  int record[BATCH_LANES];	// Record running in each lane
+  unsigned int read[BATCH_LANES];	// Values of the record read so far
+  std::string output[BATCH_LANES];	// Everything the record wrote
+};
+
+struct batchStats
+{
+  long records;
+  long steps;		// Instructions issued for the whole group
+  long lanes;		// Lanes doing work, added up over every step
+  bool simd;		// AVX2 was used
+};
+
+void loadRecords(std::istream &, std::vector<std::vector<int> > &);
+void runBatch(const program &, const std::vector<std::vector<int> > &, std::ostream &,
+              batchStats &);
+bool batchSimd();
+
+void startLane(laneGroup &, const program &, int, int);
+bool stepLane(laneGroup &, const program &, const std::vector<std::vector<int> > &,
+              int, std::string &);
+void stepScalar(laneGroup &, const instr &, int);
+void stepSimd(laneGroup &, const instr &, int);
+
+#endif
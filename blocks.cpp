@@ -0,0 +1,314 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Parses the statements of the outer block at once for comp
+ * --parallel-parse. The tokens of the whole file are built first,
+ * see chunks.cpp, so the braces can be matched before parsing.
+ *
+ * With every { matched to its }, each statement of the outer block
+ * can be found without parsing it. A statement other than a block,
+ * iffy, or loop ends at the next ;, since no ; appears inside one.
+ * A block ends at its }, and an iffy or loop at the ; after the
+ * statement following its ] (and then). Comments never reach the
+ * token list, so a brace in one is never matched. Worker threads
+ * then take statements in turn and parse each one as stat() would.
+ *
+ * The parser itself runs as before on the main thread. Each time it
+ * is about to parse a statement of the outer block, it asks for the
+ * tree of a statement starting at the same token. The tree is used
+ * only if its worker stopped exactly at the end found for it, so it
+ * is the tree stat() would have built there. Anything else, such as
+ * a statement with a parse error, is parsed again by the main thread,
+ * so errors, the order they are printed in, and the tree are the same
+ * as parsing without threads. Only the outer block is split, as
+ * nearly every statement of a program sits in it.
+ */
+
+#include "blocks.h"
+#include "parser.h"
+#include "scanner.h"
+#include "driver.h"
+#include "chunks.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+using namespace std;
+
+static int parallelParse = 0;	// Threads, -1 for one per processor, 0 for off
+static vector<token> tokens;	// Every token of the file
+static string note;		// Warning or error from the driver
+static bool fatal = false;	// Lexing stopped at the error in note
+static unsigned int noteAt = 0;	// Tokens built before note
+static token endToken;		// Given after the last token
+static vector<unsigned int> starts;	// First token of each statement of the outer block
+static vector<unsigned int> stops;	// Token after each statement
+static vector<Node*> trees;	// Each statement parsed, NULL if it could not be
+static unsigned int nextStat = 0;	// Next statement for a worker to take
+static unsigned int nextAhead = 0;	// Next statement the parser may use
+static __thread unsigned int cursor = 0;	// Next token the calling thread takes
+
+/* Turns on parsing in parallel with a number of threads, -1 for one
+ * per processor, or 0 to turn it off.
+ */
+void setParallelParse(int threads)
+{
+  parallelParse = threads;
+}
+
+/* Number of threads asked for, 0 if parsing in parallel is off.
+ */
+int getParallelParse()
+{
+  return parallelParse;
+}
+
+/* Parses every statement of the outer block on worker threads, once
+ * lexFile has built the tokens. scanToken gives the tokens to the
+ * parser afterwards, and the parser takes the trees through
+ * parsedAhead in place of parsing those statements again.
+ */
+void parseAhead()
+{
+  tokens.clear();
+  joinLexed(tokens, note, fatal, noteAt);
+  endToken.id = EOF_tk;
+  endToken.tokenString = "EOF";
+  endToken.offset = tokens.empty() ? 0 : tokens.back().offset;
+
+  vector<int> match;
+  matchBraces(tokens, match);
+  findStats(tokens, match);
+  trees.assign(starts.size(), (Node*)NULL);
+
+  int threads = parallelParse;
+  if(threads < 0)
+  {
+    long most = tokens.size() / MIN_PARSE + 1;
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    threads = max(1, (int)min((long)threads, most));
+  }
+  threads = min(threads, (int)starts.size());
+  nextStat = 0;
+  vector<pthread_t> workers(threads);
+  for(int i = 0; i < threads; i++)
+  {
+    if(pthread_create(&workers[i], NULL, parseThread, NULL) != 0)
+    {
+      cout << "Unable to start parsing threads.\n";
+      exit(1);
+    }
+  }
+  for(int i = 0; i < threads; i++)
+  {
+    pthread_join(workers[i], NULL);
+  }
+
+  cursor = 0;
+  nextAhead = 0;
+  setTokenSource(takeParsed);
+  setAheadHook(parsedAhead);
+}
+
+/* Gives the parser on the main thread the next token, printing the
+ * driver message that came before it if there was one.
+ */
+token takeParsed()
+{
+  if(cursor == noteAt && !note.empty())
+  {
+    printNotice(note, fatal);
+    note = "";
+  }
+  return cursor < tokens.size() ? tokens[cursor++] : endToken;
+}
+
+/* Gives the tree of the statement of the outer block starting at the
+ * token the parser holds, and moves past its tokens. NULL if there
+ * is none, leaving the parser to parse it.
+ */
+Node* parsedAhead()
+{
+  unsigned int at = cursor - 1;
+  while(nextAhead < starts.size() && starts[nextAhead] < at)
+  {
+    nextAhead++;
+  }
+  if(nextAhead < starts.size() && starts[nextAhead] == at && trees[nextAhead])
+  {
+    cursor = stops[nextAhead];
+    return trees[nextAhead++];
+  }
+  return NULL;
+}
+
+/* Fills match with the index of the brace matching each { and },
+ * or -1 for tokens that are not braces or have no match.
+ */
+void matchBraces(const vector<token> &tokens, vector<int> &match)
+{
+  match.assign(tokens.size(), -1);
+  vector<unsigned int> open;
+  for(unsigned int i = 0; i < tokens.size(); i++)
+  {
+    if(tokens[i].id == OBRACE_tk)
+    {
+      open.push_back(i);
+    }
+    else if(tokens[i].id == CBRACE_tk && !open.empty())
+    {
+      match[i] = open.back();
+      match[open.back()] = i;
+      open.pop_back();
+    }
+  }
+}
+
+/* Finds where each statement of the outer block starts and ends.
+ * The outer block is the first {, after the declarations of the
+ * program, and its own declarations are skipped. Finding stops at
+ * the first statement that does not look right, leaving the rest
+ * to the parser.
+ */
+void findStats(const vector<token> &tokens, const vector<int> &match)
+{
+  starts.clear();
+  stops.clear();
+  unsigned int i = 0;
+  while(i < tokens.size() && tokens[i].id != OBRACE_tk)
+  {
+    i++;
+  }
+  if(i == tokens.size() || match[i] < 0)
+  {
+    return;
+  }
+
+  unsigned int close = match[i];
+  i++;
+  // declare IDENTIFIER := INTEGER ;
+  while(idAt(tokens, i) == DECLARE_tk)
+  {
+    i += 5;
+  }
+  while(i < close)
+  {
+    unsigned int end = statEnd(tokens, match, i);
+    if(end == 0 || end > close)
+    {
+      return;
+    }
+    starts.push_back(i);
+    stops.push_back(end);
+    i = end;
+  }
+}
+
+/* Index of the token after the statement starting at i, following
+ * the same rules as stat(). 0 if it is not a statement.
+ */
+unsigned int statEnd(const vector<token> &tokens, const vector<int> &match, unsigned int i)
+{
+  tokenID id = idAt(tokens, i);
+  switch(id)
+  {
+  case OBRACE_tk:
+    return match[i] < 0 ? 0 : match[i] + 1;
+
+  // iffy [ <expr> <RO> <expr> ] then <stat> ;
+  // loop [ <expr> <RO> <expr> ] <stat> ;
+  case IFFY_tk:
+  case LOOP_tk:
+    i++;
+    if(idAt(tokens, i) != OBRACKET_tk)
+    {
+      return 0;
+    }
+    while(i < tokens.size() && tokens[i].id != CBRACKET_tk)
+    {
+      i++;
+    }
+    i++;
+    if(id == IFFY_tk && idAt(tokens, i++) != THEN_tk)
+    {
+      return 0;
+    }
+    i = statEnd(tokens, match, i);
+    return i != 0 && idAt(tokens, i) == SCOLON_tk ? i + 1 : 0;
+
+  case IN_tk:
+  case OUT_tk:
+  case IDENT_tk:
+  case LABEL_tk:
+  case GOTO_tk:
+    while(i < tokens.size())
+    {
+      switch(tokens[i].id)
+      {
+      case SCOLON_tk:
+        return i + 1;
+      case OBRACE_tk:
+      case CBRACE_tk:
+      case EOF_tk:
+        return 0;
+      default:
+        i++;
+      }
+    }
+    return 0;
+
+  default:
+    return 0;
+  }
+}
+
+/* Id of token i, or EOF_tk past the last one.
+ */
+tokenID idAt(const vector<token> &tokens, unsigned int i)
+{
+  return i < tokens.size() ? tokens[i].id : EOF_tk;
+}
+
+/* Thread body for a worker. Takes statements in turn and keeps
+ * each tree whose parse stopped at the end found for it.
+ */
+void *parseThread(void *)
+{
+  setTokenSource(takeAhead);
+  setAbortHook(abortStat);
+  unsigned int i;
+  while((i = __atomic_fetch_add(&nextStat, 1, __ATOMIC_RELAXED)) < starts.size())
+  {
+    cursor = starts[i];
+    Node* tree = parseStat(1);
+    // stat() has taken one token past the statement.
+    if(cursor == stops[i] + 1)
+    {
+      trees[i] = tree;
+    }
+  }
+  return NULL;
+}
+
+/* Gives a worker the next token. Driver messages are left for the
+ * main thread to print.
+ */
+token takeAhead()
+{
+  unsigned int at = cursor++;
+  return at < tokens.size() ? tokens[at] : endToken;
+}
+
+/* Ends a worker at a parse error, leaving its statement to be parsed
+ * again by the main thread, which prints the error. Statements are
+ * only found where the grammar puts them, so this happens only in a
+ * program the main thread stops at an error in anyway.
+ */
+void abortStat()
+{
+  pthread_exit(NULL);
+}
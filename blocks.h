@@ -0,0 +1,32 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for blocks.cpp.
+ */
+
+#ifndef BLOCKS_H
+#define BLOCKS_H
+
+#include "node.h"
+#include "token.h"
+#include <vector>
+
+// Fewest tokens worth a thread when the count is left to blocks.cpp.
+static const unsigned int MIN_PARSE = 4096;
+
+void setParallelParse(int);
+int getParallelParse();
+void parseAhead();
+token takeParsed();
+Node* parsedAhead();
+
+void matchBraces(const std::vector<token> &, std::vector<int> &);
+void findStats(const std::vector<token> &, const std::vector<int> &);
+unsigned int statEnd(const std::vector<token> &, const std::vector<int> &, unsigned int);
+tokenID idAt(const std::vector<token> &, unsigned int);
+void *parseThread(void *);
+token takeAhead();
+void abortStat();
+
+#endif
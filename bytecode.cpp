@@ -0,0 +1,257 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Binary form of VirtMach programs, written by comp --emit=bytecode.
+ *
+ * Everything is a 32 bit little endian word, so the file can be
+ * mapped into memory and read in place without any parsing:
+ * 	"VMBC"			magic
+ * 	version			BYTE_VERSION
+ * 	instructions		count
+ * 	variables		count
+ * 	name bytes		size of the name table
+ * 	op, arg			per instruction
+ * 	initial value		per variable
+ * 	name table		variable names, each ending in '\0',
+ * 				padded to a whole word
+ * An op has IMMEDIATE_FLAG set when arg is an integer. Otherwise
+ * arg is a variable index, or the instruction index a branch goes to.
+ * Label names are not kept, since only branches refer to them.
+ * Variable names are only kept to convert back to text.
+ */
+
+#include "bytecode.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+static const char BYTE_MAGIC[] = "VMBC";
+static const int BYTE_VERSION = 1;
+static const int HEADER_WORDS = 5;
+static const int IMMEDIATE_FLAG = 0x100;
+
+/* Writes a loaded program in the binary form described above.
+ */
+void writeBytecode(ostream &out, const program &prog)
+{
+  string names;
+  for(unsigned int i = 0; i < prog.names.size(); i++)
+  {
+    names += prog.names[i];
+    names += '\0';
+  }
+  while(names.length() % 4 != 0)
+  {
+    names += '\0';
+  }
+
+  out.write(BYTE_MAGIC, 4);
+  putWord(out, BYTE_VERSION);
+  putWord(out, prog.code.size());
+  putWord(out, prog.data.size());
+  putWord(out, names.length());
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    putWord(out, prog.code[i].op | (prog.code[i].immediate ? IMMEDIATE_FLAG : 0));
+    putWord(out, prog.code[i].arg);
+  }
+  for(unsigned int i = 0; i < prog.data.size(); i++)
+  {
+    putWord(out, prog.data[i]);
+  }
+  out.write(names.data(), names.length());
+}
+
+/* Loads a binary program with a single mmap of the file. Every
+ * count and index is checked against the file before use, so
+ * a damaged file is reported instead of run.
+ */
+void loadBytecode(string filename, program &prog)
+{
+  int file = open(filename.c_str(), O_RDONLY);
+  if(file < 0)
+  {
+    vmError("Unable to open file", filename);
+  }
+  struct stat info;
+  if(fstat(file, &info) < 0 || info.st_size < HEADER_WORDS * 4)
+  {
+    close(file);
+    vmError("Not a bytecode file", filename);
+  }
+  unsigned int size = info.st_size;
+  void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if(mapped == MAP_FAILED)
+  {
+    vmError("Unable to map file", filename);
+  }
+  const unsigned char *bytes = static_cast<const unsigned char *>(mapped);
+
+  if(string((const char *)bytes, 4).compare(BYTE_MAGIC) != 0)
+  {
+    vmError("Not a bytecode file", filename);
+  }
+  if(getWord(bytes, 1) != BYTE_VERSION)
+  {
+    vmError("Unsupported bytecode version in", filename);
+  }
+  unsigned int codeSize = getWord(bytes, 2);
+  unsigned int dataSize = getWord(bytes, 3);
+  unsigned int nameSize = getWord(bytes, 4);
+  // Sizes are compared in words so huge counts cannot wrap around.
+  unsigned int words = size / 4 - HEADER_WORDS;
+  if(size % 4 != 0 || nameSize % 4 != 0 || codeSize > words / 2
+     || dataSize > words - codeSize * 2
+     || nameSize / 4 != words - codeSize * 2 - dataSize)
+  {
+    vmError("Sections do not match the size of", filename);
+  }
+
+  unsigned int at = HEADER_WORDS;
+  prog.code.resize(codeSize);
+  for(unsigned int i = 0; i < codeSize; i++, at += 2)
+  {
+    int op = getWord(bytes, at);
+    instr &cur = prog.code[i];
+    cur.immediate = (op & IMMEDIATE_FLAG) != 0;
+    op &= ~IMMEDIATE_FLAG;
+    cur.arg = getWord(bytes, at + 1);
+    if(op < READ_op || op > STOP_op)
+    {
+      vmError("Unknown instruction in", filename);
+    }
+    cur.op = static_cast<opCode>(op);
+
+    bool branch = cur.op >= BR_op && cur.op <= BRZERO_op;
+    bool none = cur.op == NOOP_op || cur.op == STOP_op;
+    unsigned int limit = branch ? codeSize : dataSize;
+    if(!none && (branch || !cur.immediate) && (unsigned int)cur.arg >= limit)
+    {
+      vmError("Argument out of range in", filename);
+    }
+  }
+  if(codeSize == 0 || prog.code.back().op != STOP_op)
+  {
+    vmError("Program does not end with", "STOP");
+  }
+  prog.lines.assign(codeSize, 0);
+
+  prog.data.resize(dataSize);
+  for(unsigned int i = 0; i < dataSize; i++, at++)
+  {
+    prog.data[i] = getWord(bytes, at);
+  }
+
+  // Names are only needed to convert back to text, but a missing
+  // one still gets a usable name.
+  const char *names = (const char *)(bytes + at * 4);
+  unsigned int pos = 0;
+  for(unsigned int i = 0; i < dataSize; i++)
+  {
+    string name;
+    while(pos < nameSize && names[pos] != '\0')
+    {
+      name += names[pos++];
+    }
+    pos++;
+    if(name.empty() || prog.vars.find(name) != prog.vars.end())
+    {
+      stringstream unnamed;
+      unnamed << "V" << i;
+      name = unnamed.str();
+    }
+    prog.names.push_back(name);
+    prog.vars.insert(pair<string, int>(name, i));
+  }
+
+  munmap(mapped, size);
+}
+
+/* True if a file starts with the bytecode magic.
+ */
+bool isBytecode(string filename)
+{
+  ifstream file(filename.c_str(), ios::binary);
+  char magic[4];
+  return file.read(magic, 4) && string(magic, 4).compare(BYTE_MAGIC) == 0;
+}
+
+/* Writes a loaded program back out as .asm text. Every branch
+ * target gets a label named after its instruction index.
+ */
+void writeText(ostream &out, const program &prog)
+{
+  map<int, string> labels;
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    const instr &cur = prog.code[i];
+    if(cur.op >= BR_op && cur.op <= BRZERO_op)
+    {
+      stringstream name;
+      name << "L" << cur.arg;
+      labels[cur.arg] = name.str();
+    }
+  }
+
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    const instr &cur = prog.code[i];
+    if(labels.find(i) != labels.end())
+    {
+      out << labels[i] << ": ";
+    }
+    opCode op = cur.op;
+    out << opName(op);
+    if(op >= BR_op && op <= BRZERO_op)
+    {
+      out << " " << labels[cur.arg];
+    }
+    else if(cur.immediate)
+    {
+      out << " " << cur.arg;
+    }
+    else if(op != NOOP_op && op != STOP_op)
+    {
+      out << " " << prog.names[cur.arg];
+    }
+    out << endl;
+  }
+
+  for(unsigned int i = 0; i < prog.data.size(); i++)
+  {
+    out << prog.names[i] << " " << prog.data[i] << endl;
+  }
+}
+
+/* Writes one little endian word.
+ */
+void putWord(ostream &out, int word)
+{
+  unsigned int value = word;
+  char bytes[4];
+  for(int i = 0; i < 4; i++)
+  {
+    bytes[i] = (value >> (8 * i)) & 0xff;
+  }
+  out.write(bytes, 4);
+}
+
+/* Reads the little endian word at a word index.
+ */
+int getWord(const unsigned char *bytes, unsigned int index)
+{
+  const unsigned char *word = bytes + index * 4;
+  unsigned int value = word[0] | (word[1] << 8) | (word[2] << 16)
+                     | ((unsigned int)word[3] << 24);
+  return (int)value;
+}
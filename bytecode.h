@@ -0,0 +1,25 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for bytecode.cpp.
+ * Programs are the resolved form from virtMach.h, so either
+ * file form can be written from anything that was loaded.
+ */
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "virtMach.h"
+#include <ostream>
+#include <string>
+
+void writeBytecode(std::ostream &, const program &);
+void loadBytecode(std::string, program &);
+bool isBytecode(std::string);
+void writeText(std::ostream &, const program &);
+
+void putWord(std::ostream &, int);
+int getWord(const unsigned char *, unsigned int);
+
+#endif
@@ -0,0 +1,260 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Lexes a file in parallel for comp --parallel-lex. The file the
+ * scanner read into memory is split into chunks, each ending just
+ * after a newline, and every chunk is lexed by the driver on its own
+ * thread.
+ *
+ * Whitespace and # end any token, so no token crosses a newline and
+ * a chunk never starts in the middle of one. Tokens keep their offset
+ * in the whole file, so lines need nothing from the chunks before.
+ * What a chunk does depend on is whether a comment is open at its
+ * start. filterInput is the only place a # is ever read, and every #
+ * it reads opens or closes a comment, so a comment is open at the
+ * start of a chunk exactly when an odd number of # come before it.
+ * Rather than lexing each chunk twice, once for each state, a first
+ * pass counts the # of every chunk in parallel. That takes a small
+ * part of the time lexing does, and leaves no guess to throw away.
+ * Adding up the counts of the chunks before gives each chunk its
+ * state, then every chunk is lexed at once and the tokens are joined
+ * in order.
+ *
+ * A scanner error stops its chunk, and chunks after it are never
+ * used. The error is printed when the parser reaches it, the same
+ * as lexing the whole file in one go would, so a parse error earlier
+ * in the file still comes first.
+ */
+
+#include "chunks.h"
+#include "driver.h"
+#include "scanner.h"
+#include "fsa.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+using namespace std;
+
+static int parallelLex = 0;	// Chunks to split into, -1 for one per processor, 0 for off
+static __thread lexChunk *current = NULL;	// Chunk the calling thread is lexing
+static vector<lexChunk> chunks;	// The file, lexed a chunk at a time
+static unsigned int chunkAt = 0;	// Chunk the parser takes tokens from
+static unsigned int nextToken = 0;	// Next token of that chunk
+
+/* Turns on lexing in parallel with the file split into a number of
+ * chunks, -1 for one per processor, or 0 to turn it off.
+ */
+void setParallelLex(int chunks)
+{
+  parallelLex = chunks;
+}
+
+/* Number of chunks asked for, 0 if lexing in parallel is off.
+ */
+int getParallelLex()
+{
+  return parallelLex;
+}
+
+/* Lexes the whole file in parallel. scanToken gives the tokens to the
+ * parser afterwards, see takeLexed.
+ */
+void lexFile()
+{
+  const char *begin;
+  const char *end;
+  getInputText(begin, end);
+
+  int parts = parallelLex;
+  if(parts < 0)
+  {
+    long most = (end - begin) / MIN_CHUNK + 1;
+    parts = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    parts = max(1, (int)min((long)parts, most));
+  }
+  chunks.clear();
+  splitText(begin, end, parts, chunks);
+  chunks.back().last = true;
+
+  // Every thread reads the table, so it is built before any start.
+  initFSA();
+  runChunks(chunks, countChunk);
+  bool comment = false;
+  for(unsigned int i = 0; i < chunks.size(); i++)
+  {
+    chunks[i].comment = comment;
+    comment = comment != (chunks[i].hashes % 2 == 1);
+  }
+  runChunks(chunks, lexChunkText);
+
+  chunkAt = 0;
+  nextToken = 0;
+  setTokenSource(takeLexed);
+}
+
+/* Gives the parser the next token of the file, printing the driver
+ * message that came before it if there was one. Tokens are taken
+ * from each chunk in turn, so they are never copied into one list.
+ * A chunk stopped by an error exits here, before any chunk after it.
+ */
+token takeLexed()
+{
+  while(true)
+  {
+    lexChunk &chunk = chunks[chunkAt];
+    if(nextToken == chunk.noteAt && !chunk.note.empty())
+    {
+      printNotice(chunk.note, chunk.fatal);
+      chunk.note = "";
+    }
+    if(nextToken < chunk.tokens.size())
+    {
+      return chunk.tokens[nextToken++];
+    }
+    vector<token>().swap(chunk.tokens);
+    chunkAt++;
+    nextToken = 0;
+  }
+}
+
+/* Joins the tokens of every chunk into one list, for parsing
+ * parts of it at once. The driver message kept, if any, comes with
+ * the number of tokens before it. Nothing after an error is used.
+ */
+void joinLexed(vector<token> &tokens, string &note, bool &fatal, unsigned int &noteAt)
+{
+  note = "";
+  fatal = false;
+  noteAt = 0;
+  for(unsigned int i = 0; i < chunks.size() && !fatal; i++)
+  {
+    lexChunk &chunk = chunks[i];
+    if(note.empty() && !chunk.note.empty())
+    {
+      note = chunk.note;
+      fatal = chunk.fatal;
+      noteAt = tokens.size() + chunk.noteAt;
+    }
+    tokens.insert(tokens.end(), chunk.tokens.begin(), chunk.tokens.end());
+    vector<token>().swap(chunk.tokens);
+  }
+  chunks.clear();
+}
+
+/* Splits text from begin to end into about parts chunks of the same
+ * size. Each chunk but the last ends just after a newline, so there
+ * may be fewer chunks than asked for.
+ */
+void splitText(const char *begin, const char *end, int parts, vector<lexChunk> &chunks)
+{
+  const char *start = begin;
+  for(int i = 1; i <= parts && (start < end || chunks.empty()); i++)
+  {
+    const char *stop = end;
+    if(i < parts)
+    {
+      stop = max(begin + (end - begin) / parts * i, start + 1);
+      while(stop < end && stop[-1] != '\n')
+      {
+        stop++;
+      }
+    }
+    stop = min(stop, end);
+    addChunk(chunks, start, stop);
+    start = stop;
+  }
+}
+
+/* Adds a chunk from begin to end with nothing counted or lexed yet.
+ */
+void addChunk(vector<lexChunk> &chunks, const char *begin, const char *end)
+{
+  lexChunk chunk;
+  chunk.begin = begin;
+  chunk.end = end;
+  chunks.push_back(chunk);
+  lexChunk &added = chunks.back();
+  added.last = false;
+  added.hashes = 0;
+  added.comment = false;
+  added.fatal = false;
+  added.noteAt = 0;
+}
+
+/* Runs body on every chunk at once, one thread each, and waits for
+ * all of them.
+ */
+void runChunks(vector<lexChunk> &chunks, void *(*body)(void *))
+{
+  vector<pthread_t> threads(chunks.size());
+  for(unsigned int i = 0; i < chunks.size(); i++)
+  {
+    if(pthread_create(&threads[i], NULL, body, &chunks[i]) != 0)
+    {
+      cout << "Unable to start lexing threads.\n";
+      exit(1);
+    }
+  }
+  for(unsigned int i = 0; i < chunks.size(); i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+/* Thread body counting the # of a chunk.
+ */
+void *countChunk(void *arg)
+{
+  lexChunk &chunk = *static_cast<lexChunk *>(arg);
+  const char *at = chunk.begin;
+  while((at = static_cast<const char *>(memchr(at, '#', chunk.end - at))) != NULL)
+  {
+    chunk.hashes++;
+    at++;
+  }
+  return NULL;
+}
+
+/* Thread body building the tokens of a chunk with the driver,
+ * starting from the comment state found for it.
+ */
+void *lexChunkText(void *arg)
+{
+  lexChunk &chunk = *static_cast<lexChunk *>(arg);
+  lexState state = {"", chunk.comment, !chunk.last, chunkNotice};
+  current = &chunk;
+  setLexState(&state);
+  setInputText(chunk.begin, chunk.end);
+
+  token tk;
+  do
+  {
+    tk = getToken();
+    if(tk.id != EOF_tk || chunk.last)
+    {
+      chunk.tokens.push_back(tk);
+    }
+  } while(tk.id != EOF_tk);
+  return NULL;
+}
+
+/* Keeps a warning or error from the driver with the chunk it came
+ * from. The thread ends after an error, as the driver expects
+ * nothing to return from one.
+ */
+void chunkNotice(string text, bool fatal)
+{
+  current->note = text;
+  current->fatal = fatal;
+  current->noteAt = current->tokens.size();
+  if(fatal)
+  {
+    pthread_exit(NULL);
+  }
+}
@@ -0,0 +1,44 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for chunks.cpp.
+ */
+
+#ifndef CHUNKS_H
+#define CHUNKS_H
+
+#include "token.h"
+#include <string>
+#include <vector>
+
+// Smallest chunk worth a thread when the count is left to chunks.cpp.
+static const long MIN_CHUNK = 1 << 20;
+
+struct lexChunk
+{
+  const char *begin;	// Starts just after a newline, or at the start of the file
+  const char *end;
+  bool last;		// Ends the file
+  int hashes;		// Number of # in the chunk
+  bool comment;		// Starts inside a comment
+  std::vector<token> tokens;	// Tokens built, the EOF token only if last
+  std::string note;	// Warning or error from the driver
+  bool fatal;		// Lexing stopped at the error in note
+  unsigned int noteAt;	// Tokens built before note
+};
+
+void setParallelLex(int);
+int getParallelLex();
+void lexFile();
+token takeLexed();
+void joinLexed(std::vector<token> &, std::string &, bool &, unsigned int &);
+
+void splitText(const char *, const char *, int, std::vector<lexChunk> &);
+void addChunk(std::vector<lexChunk> &, const char *, const char *);
+void runChunks(std::vector<lexChunk> &, void *(*)(void *));
+void *countChunk(void *);
+void *lexChunkText(void *);
+void chunkNotice(std::string, bool);
+
+#endif
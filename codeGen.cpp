@@ -8,33 +8,83 @@
  * 	T#
  * 	L#
  * and uses these to mark these special program generated variables.
+ *
+ * Expressions computed earlier in the same block are reused through
+ * local value numbering: every expression with an operator is saved
+ * to a temporary, and computing the same expression again loads it
+ * instead. Saved values are forgotten when a variable they use is
+ * written, and entirely at every label since other code may jump there.
+ * Saves that are never loaded are removed again in optimize.cpp.
+ *
+ * State used while generating is kept per thread, so segments of the
+ * outer block can be generated at once, see segments.cpp.
  */
 
 #include "codeGen.h"
+#include "optimize.h"
+#include "simplify.h"
+#include "unroll.h"
+#include "virtMach.h"
+#include "bytecode.h"
+#include "native.h"
+#include "segments.h"
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <iterator>
+#include <algorithm>
 #include <stdlib.h>
 #include <map>
+#include <set>
+#include <vector>
 using namespace std;
 
 // I was going to rename all variables for code generation to avoid
 // any duplicates with temporary variables, but after the video
 // I'll leave them as they are and mark temp variables the other way.
-static map<string, int> decTemp;	// Store values for variables when declared.
+static thread_local map<string, int> decTemp;	// Store values for variables when declared.
 static ofstream outFile;		// Allows multiple functions easy access to file.
+static thread_local vector<asmLine> code;	// Generated lines, written once optimized.
 
-static int labelCount = 0;	// Track number of unique labels
+// Rough cost of MULT in VirtMach compared to a LOAD, STORE, or ADD.
+static const int MULT_COST = 3;
+
+static __thread int labelCount = 0;	// Track number of unique labels
 				// Labels cannot be reused in the same way as temp variables
 
 static const int VAR_DEFAULT = 2;
-static int varCount = VAR_DEFAULT;	// Track number of unique temporary variables
+static __thread int varCount = VAR_DEFAULT;	// Track number of unique temporary variables
 				// T0 reserved for some <stat>s, set to VAR_DEFAULT to reset
 				// Multiple temporary variables are not needed
 				// across <expr>'s from different statements
-static bool t0out = true;	// Track existance of T0 without searching map
+static __thread int varFloor = VAR_DEFAULT;	// Lowest temporary variable statements may reuse
+				// Raised inside loops to protect hoisted values
+static __thread bool t0out = true;	// Track existance of T0 without searching map
+static long evalBudget = 0;	// Instructions allowed for partial evaluation, 0 for off
+struct cseEntry
+{
+  string temp;		// Temporary holding the value
+  set<string> vars;	// Variables the value was computed from
+};
+static thread_local map<string, cseEntry> available;	// Expressions already computed in this block
+static thread_local map<Node*, string> keys;	// Text of each expression, same for equal values
+static __thread int cseCount = 0;	// Saved values so far, named #0, #1... until renamed
+static __thread int maxVar = VAR_DEFAULT;	// Highest temporary variable count reached
+
+static thread_local map<Node*, int> needs;	// Temporaries needed for each expression
+static thread_local map<Node*, string> hoisted;	// Loop invariant expressions and the
+						// temporary variable holding their value
+static thread_local map<string, vector<pair<string, int> > > steps;	// Reduced temporaries advanced
+									// with each induction variable
+// Per iteration cost of advancing a reduced temporary: LOAD, ADD, STORE.
+static const int STEP_COST = 3;
+static emitType emitMode = ASM_emit;	// Form of the output file
+static bool showRemarks = false;	// Print optimization decisions
+static bool lineMap = false;		// Write the source line of each instruction
+static bool simplified = false;		// Expressions were already simplified
+static __thread int curLine = 0;	// Source line of the statement being generated
+static thread_local vector<pair<int, string> > remarks;	// Decisions and their source lines
 
 /* Auxiliary function for code generation. Takes the root node of the
  * parse tree and a filename to output code to.
@@ -42,10 +92,23 @@ static bool t0out = true;	// Track existance of T0 without searching map
 void codeGeneration(Node* root, string filename)
 {
   // On file write success, generate code. Else output error.
-  outFile.open(filename.c_str());
+  outFile.open(filename.c_str(), emitMode == BYTECODE_emit ? ios::binary : ios::out);
   if(outFile.is_open())
   {
-    recGen(root);
+    if(!simplified)
+    {
+      simplifyTree(root);
+    }
+    planUnroll(root);
+    if(getParallelGen() != 0)
+    {
+      genParallel(root);
+    }
+    else
+    {
+      recGen(root);
+    }
+    nameSaved();
   }
   else
   {
@@ -54,8 +117,28 @@ void codeGeneration(Node* root, string filename)
     exit(1);
   }
 
-  // Finish off .asm with final keyword and initial values.
+  // Finish off .asm with final keyword, optimize, then
+  // write it out with initial values.
+  emit("STOP");
+  optimizeCode(code, decTemp);
+  if(evalBudget > 0)
+  {
+    evaluateProgram(code, decTemp, evalBudget);
+  }
   writeFinal();
+  if(lineMap)
+  {
+    writeLineMap(filename);
+  }
+
+  if(showRemarks)
+  {
+    stable_sort(remarks.begin(), remarks.end());
+    for(unsigned int i = 0; i < remarks.size(); i++)
+    {
+      cout << "line " << remarks[i].first << ": " << remarks[i].second << endl;
+    }
+  }
 
   if(outFile.is_open())
   {
@@ -63,6 +146,84 @@ void codeGeneration(Node* root, string filename)
   }
 }
 
+/* Turns on whole program partial evaluation, allowing the
+ * program to run up to budget instructions at compile time.
+ */
+void setEvalBudget(long budget)
+{
+  evalBudget = budget;
+}
+
+/* Chooses between .asm text, the binary form in bytecode.cpp,
+ * and x86-64 assembler from native.cpp.
+ */
+void setEmit(emitType mode)
+{
+  emitMode = mode;
+}
+
+/* Gives the chosen output form, so the file gets a matching name.
+ */
+emitType getEmit()
+{
+  return emitMode;
+}
+
+/* Turns on printing what optimizations decided and why.
+ */
+void setOptRemarks(bool show)
+{
+  showRemarks = show;
+}
+
+/* Turns on writing a .map file next to the output, giving the
+ * source line of every instruction for the profiler in vmsim.
+ */
+void setLineMap(bool write)
+{
+  lineMap = write;
+}
+
+/* Marks the tree as simplified already, by pipeline.cpp as each
+ * statement was parsed. simplifyTree is not run a second time.
+ */
+void setSimplified(bool done)
+{
+  simplified = done;
+}
+
+/* Records an optimization decision about a source line,
+ * printed after code generation when remarks are on.
+ */
+void remark(int line, string text)
+{
+  remarks.push_back(pair<int, string>(line, text));
+}
+
+/* Add an instruction to the end of the generated code.
+ */
+void emit(string op, string arg)
+{
+  asmLine line;
+  line.op = op;
+  line.arg = arg;
+  line.line = curLine;
+  code.push_back(line);
+}
+
+/* Add a label with no actual instruction.
+ */
+void emitLabel(string label)
+{
+  asmLine line;
+  line.label = label;
+  line.op = "NOOP";
+  line.line = curLine;
+  code.push_back(line);
+  // Other code may branch here, so nothing saved is known to hold.
+  available.clear();
+}
+
 /* Generate temporary variable names and labels.
  * Anything that uses expressions will make use of temporary
  * variables T#. Iffy and loop statements use these labels.
@@ -73,6 +234,7 @@ string newName(nameType type)
   if(type == VAR)
   {
     name << "T" << varCount++;
+    maxVar = max(maxVar, varCount);
 
     // Stores any new temporary variable to be initialized
     if(decTemp.find(name.str()) == decTemp.end())
@@ -100,9 +262,21 @@ void recGen(Node* node)
     return;
   }
 
+  // <stat> marks everything generated for it with its source
+  // line. The enclosing statement takes over again afterwards,
+  // so the end of an iffy or loop belongs to the iffy or loop.
+  if(node->label.compare("stat") == 0)
+  {
+    int outer = curLine;
+    curLine = lineOf(node);
+    recGen(node->child1);
+    curLine = outer;
+    return;
+  }
+
   // <vars> may have children, so after generating code
   // travel to its child.
-  if(node->label.compare("vars") == 0)
+  else if(node->label.compare("vars") == 0)
   {
     genVars(node);
     recGen(node->child1);
@@ -189,278 +363,1413 @@ void genVars(Node* node)
  */
 void genIn(Node* node)
 {
-  outFile << "READ " << node->token1.tokenString << endl;
+  emit("READ", node->token1.tokenString);
+  forgetVar(node->token1.tokenString);
 }
 
 /* Use a temp variable for the value from the expression.
  * Always uses the same one to save on space.
  * Stores the value and outputs it to the user.
+ * A lone variable is written directly without the temp.
  * Ends by resetting the temp variable count to reuse names.
  */
 void genOut(Node* node)
 {
+  string leaf;
+  if(isLeaf(node->child1, leaf) && isVariable(leaf))
+  {
+    emit("WRITE", leaf);
+    return;
+  }
   string temp = "T0";
   if(t0out)
   {
     decTemp.insert(pair<string, int>(temp, 0));
     t0out = false;
   }
-  genExpr(node->child1);
-  outFile << "STORE " << temp << endl;
-  outFile << "WRITE " << temp << endl;
-  varCount = VAR_DEFAULT;
+  genPart(node->child1);
+  emit("STORE", temp);
+  emit("WRITE", temp);
+  varCount = varFloor;
 }
 
-/* Use a temp variable for first expression and set a label.
- * Subtracts result of one expression from another to
- * compare in <RO>. Recursively calls recGen to write
- * statements before setting a label to skip to.
+/* Set a label and compare the two expressions, see genCond.
+ * Recursively calls recGen to write statements before
+ * setting a label to skip to.
+ * A condition known at compile time needs no test, see knownCond.
  */
 void genIffy(Node* node)
 {
+  bool holds;
+  if(knownCond(node, holds) && (holds || !hasLabel(node->child4)))
+  {
+    // Always true runs the statement as is, always false
+    // has nothing to run.
+    if(holds)
+    {
+      recGen(node->child4);
+    }
+    varCount = varFloor;
+    return;
+  }
+
   string label = newName(LABEL);
-  string temp = "T0";
-  if(t0out)
+  // Never true, but a goto may still land inside.
+  if(knownCond(node, holds))
   {
-    decTemp.insert(pair<string, int>(temp, 0));
-    t0out = false;
+    emit("BR", label);
+    recGen(node->child4);
+    emitLabel(label);
+    varCount = varFloor;
+    return;
   }
-  genExpr(node->child3);
-  outFile << "STORE " << temp << endl;
-  genExpr(node->child1);
-  outFile << "SUB " << temp << endl;
-  genRO(node->child2, label);
+  bool mirror = genCond(node);
+  genRO(node->child2, label, false, mirror);
   // Takes the place of going into a <stat>
   recGen(node->child4);
-  outFile << label << ": NOOP\n";
-  varCount = VAR_DEFAULT;
+  emitLabel(label);
+  varCount = varFloor;
 }
 
-/* Set up two labels for start and end of loop. Uses a
- * temp variable for first expression. Subtracts result of one
- * from another to compare in <RO>. Recursively calls recGen to
- * write statements before setting the exit label. Just before
- * the exit label, goto the loop label always to test
- * expression results again.
+/* Set up two labels for start and end of loop. Compares
+ * the two expressions as in genCond.
+ * The loop is rotated: the condition is tested once before
+ * entering the loop to skip it entirely, then again at the
+ * bottom where the branch is taken back to the top while the
+ * condition holds. Each iteration then runs a single test and
+ * branch instead of a test at the top and a BR at the bottom.
+ * Gotos into the body still fall through to the bottom test.
+ * Expressions that do not change inside the loop are computed
+ * once before the guard, see hoistLoop, and multiplications of
+ * induction variables are stepped along with them, see reduceLoop.
+ * A condition that never holds is handled like <iffy> and one
+ * that always holds leaves just the body and a BR back to the top.
+ * Loops with a known number of iterations may be unrolled, see
+ * unroll.cpp. Fully unrolled loops are only copies of the body.
+ * Partly unrolled loops run the leftover iterations first and
+ * need no guard, since the loop is known to run at least once.
  * Warning: modify expressions inside statements or risk
  * an infinite loop.
  */
 void genLoop(Node* node)
 {
+  bool holds;
+  if(knownCond(node, holds) && !holds)
+  {
+    genIffy(node);
+    return;
+  }
+  int trips;
+  int copies = 1;
+  bool unrolled = getUnroll(node, trips, copies);
+  if(unrolled && copies == trips)
+  {
+    genCopies(node->child4, trips);
+    return;
+  }
   string loopLabel = newName(LABEL);
+  // Never ends unless a goto leaves, nothing to test.
+  if(knownCond(node, holds))
+  {
+    emitLabel(loopLabel);
+    recGen(node->child4);
+    emit("BR", loopLabel);
+    varCount = varFloor;
+    return;
+  }
   string exitLabel = newName(LABEL);
-  //string temp = newName(VAR);
-  string temp = "T0";
-  if(t0out)
+
+  // Hoisted values must survive every statement in the body,
+  // so statements inside the loop reuse temporaries above them.
+  int oldFloor = varFloor;
+  vector<Node*> moved;
+  vector<string> stepped;
+  hoistLoop(node, moved);
+  reduceLoop(node, moved, stepped);
+  varFloor = varCount;
+
+  // Guard, skips the loop if the condition fails the first time
+  if(unrolled)
   {
-    decTemp.insert(pair<string, int>(temp, 0));
-    t0out = false;
+    genCopies(node->child4, trips % copies);
+  }
+  else
+  {
+    bool mirror = genCond(node);
+    genRO(node->child2, exitLabel, false, mirror);
+    varCount = varFloor;
   }
 
-  outFile << loopLabel << ": NOOP\n";
-  genExpr(node->child3);
-  outFile << "STORE " << temp << endl;
-  genExpr(node->child1);
-  outFile << "SUB " << temp << endl;
-  genRO(node->child2, exitLabel);
+  emitLabel(loopLabel);
   // Takes the place of going into a <stat>
-  recGen(node->child4);
-  outFile << "BR " << loopLabel << endl;
-  outFile << exitLabel << ": NOOP\n";
-  varCount = VAR_DEFAULT;
+  genCopies(node->child4, copies);
+  bool mirror = genCond(node);
+  genRO(node->child2, loopLabel, true, mirror);
+  emitLabel(exitLabel);
+
+  for(unsigned int i = 0; i < moved.size(); i++)
+  {
+    hoisted.erase(moved[i]);
+  }
+  for(unsigned int i = 0; i < stepped.size(); i++)
+  {
+    steps.erase(stepped[i]);
+  }
+  varFloor = oldFloor;
+  varCount = varFloor;
 }
 
-/* Add branching instructions based on relational operators.
- * Expects the result of the second expression in a comparison
- * to be subtracted from the first.
- * If the first expression is larger, the value left is positive.
- * If the first expression is smaller, the value left is negative.
- * If they are equal, the value left is 0.
- * Because these labels skip the iffy and loop statements, the
- * branching instruction should act on the opposite condition.
- * So for "<<" which does the statement on less than or equal,
- * only skip when a positive value remains.
+/* Generates a loop body times times in a row.
  */
-void genRO(Node* node, string label)
+void genCopies(Node* node, int times)
 {
-  if(node->token1.tokenString.compare("<") == 0)
+  for(int i = 0; i < times; i++)
   {
-    // "<<" less than or equal to
-    if(node->token2.tokenString.compare("<") == 0)
-    {
-      outFile << "BRPOS " << label << endl;
-    }
-    // "<>" not equal to
-    else if(node->token2.tokenString.compare(">") == 0)
-    {
-      outFile << "BRZERO " << label << endl;
-    }
-    // "<" less than
-    else
-    {
-      outFile << "BRZPOS " << label << endl;
-    }
+    recGen(node);
+    varCount = varFloor;
   }
-  else if(node->token1.tokenString.compare(">") == 0)
+}
+
+/* Loop-invariant code motion. Finds expressions in the condition
+ * and body of a loop that only use variables never written in the
+ * body, computes them into temporaries, and records them in the
+ * hoisted map so later code loads the temporary instead.
+ * A label inside the body could let a goto enter the loop without
+ * passing the code before it, so such loops are left alone.
+ * Body expressions with a division are not moved since the loop
+ * may never run them, and they could divide by zero.
+ */
+void hoistLoop(Node* node, vector<Node*> &moved)
+{
+  if(hasLabel(node->child4))
   {
-    // ">>" greater than or equal to
-    if(node->token2.tokenString.compare(">") == 0)
+    return;
+  }
+  set<string> written;
+  findWrites(node->child4, written);
+
+  // A whole invariant side of the condition becomes a single value,
+  // so each test only needs a SUB, see genCond.
+  if(isInvariant(node->child3, written))
+  {
+    hoistExpr(node->child3, moved);
+  }
+  else if(isInvariant(node->child1, written))
+  {
+    hoistExpr(node->child1, moved);
+  }
+  findHoists(node->child1, written, moved, true);
+  findHoists(node->child3, written, moved, true);
+  findHoists(node->child4, written, moved, false);
+}
+
+/* Induction variable strength reduction. A variable stepped once
+ * per iteration by v := v + c, see findStep, changes every expression
+ * a * v + b by a * c when a and b do not change in the loop. Such
+ * expressions with a multiplication are computed into a temporary
+ * before the loop, used like hoisted values inside it, and advanced
+ * right after the step. Only done when the multiplications saved
+ * cost more than the LOAD, ADD, and STORE advancing the temporary.
+ * Expressions are grouped by key, so equal ones share a temporary.
+ */
+void reduceLoop(Node* node, vector<Node*> &moved, vector<string> &stepped)
+{
+  if(hasLabel(node->child4))
+  {
+    return;
+  }
+  set<string> written;
+  findWrites(node->child4, written);
+
+  set<string>::iterator var = written.begin();
+  for(; var != written.end(); var++)
+  {
+    int step;
+    if(!findStep(node->child4, *var, step))
     {
-      outFile << "BRNEG " << label << endl;
+      continue;
     }
-    // ">" greater than
-    else
+    vector<string> order;
+    map<string, vector<Node*> > groups;
+    findLinear(node->child1, *var, written, order, groups);
+    findLinear(node->child3, *var, written, order, groups);
+    findLinear(node->child4, *var, written, order, groups);
+
+    for(unsigned int i = 0; i < order.size(); i++)
     {
-      outFile << "BRZNEG " << label << endl;
+      vector<Node*> &uses = groups[order[i]];
+      int coef, add;
+      linearCoef(uses[0], *var, written, coef);
+      if((int)uses.size() * (exprCost(uses[0]) - 1) <= STEP_COST
+         || !canFold(MULT_ex, coef, step, add))
+      {
+        continue;
+      }
+
+      string temp = newName(VAR);
+      int mark = varCount;
+      genPart(uses[0]);
+      emit("STORE", temp);
+      varCount = mark;
+      for(unsigned int u = 0; u < uses.size(); u++)
+      {
+        hoisted.insert(pair<Node*, string>(uses[u], temp));
+        moved.push_back(uses[u]);
+      }
+      if(steps.find(*var) == steps.end())
+      {
+        stepped.push_back(*var);
+      }
+      steps[*var].push_back(pair<string, int>(temp, add));
+      remark(lineOf(uses[0]), "multiply by " + *var + " reduced to an add per iteration");
     }
   }
-  // "==" equal to
-  else
-  {
-    outFile << "BRNEG " << label << endl;
-    outFile << "BRPOS " << label << endl;
-  }
 }
 
-/* Value from expression does not need to be saved to a temporary
- * variable, the variable we want it saved to is given.
+/* Collects the largest expressions under a node that are linear
+ * in var and multiply, grouped by key in the order first found.
+ * Divisions are left alone, computing them before the loop could
+ * divide by zero where the loop would not have.
  */
-void genAssign(Node* node)
+void findLinear(Node* node, string var, set<string> &written, vector<string> &order,
+                map<string, vector<Node*> > &groups)
 {
-  genExpr(node->child1);
-  outFile << "STORE " << node->token1.tokenString << endl;
+  if(!node || hoisted.count(node) > 0)
+  {
+    return;
+  }
+  int coef;
+  bool exprNode = node->label.compare("expr") == 0 || node->label.compare("N") == 0
+               || node->label.compare("A") == 0 || node->label.compare("M") == 0
+               || node->label.compare("R") == 0;
+  if(exprNode && hasMult(node) && !hasDiv(node)
+     && linearCoef(node, var, written, coef) && coef != 0)
+  {
+    string key = getKey(node);
+    if(groups.find(key) == groups.end())
+    {
+      order.push_back(key);
+    }
+    groups[key].push_back(node);
+    return;
+  }
+  findLinear(node->child1, var, written, order, groups);
+  findLinear(node->child2, var, written, order, groups);
+  findLinear(node->child3, var, written, order, groups);
+  findLinear(node->child4, var, written, order, groups);
 }
 
-/* Set up a label with no actual instruction, for goto statements.
+/* True if an expression is coef * var plus something that does not
+ * change in the loop. Multiplying needs an integer on one side.
+ * Values wrap around, which keeps the relation exact.
  */
-void genLabel(Node* node)
+bool linearCoef(Node* node, string var, set<string> &written, int &coef)
 {
-  outFile << node->token1.tokenString << ": NOOP\n";
+  exprType type = getType(node);
+  if(type == LEAF_ex)
+  {
+    string name = node->token1.tokenString;
+    coef = name.compare(var) == 0 ? 1 : 0;
+    return coef == 1 || !isVariable(name) || written.count(name) == 0;
+  }
+  if(type == PASS_ex)
+  {
+    return linearCoef(node->child1, var, written, coef);
+  }
+  int left, right, num;
+  if(type == NEG_ex)
+  {
+    return linearCoef(node->child1, var, written, right)
+        && canFold(SUB_ex, 0, right, coef);
+  }
+  if(type == DIV_ex || !linearCoef(node->child1, var, written, left)
+     || !linearCoef(node->child2, var, written, right))
+  {
+    return false;
+  }
+  if(type == ADD_ex || type == SUB_ex)
+  {
+    return canFold(type, left, right, coef);
+  }
+  if(left == 0 && right == 0)
+  {
+    coef = 0;
+    return true;
+  }
+  if(getConst(node->child2, num))
+  {
+    return canFold(MULT_ex, left, num, coef);
+  }
+  if(getConst(node->child1, num))
+  {
+    return canFold(MULT_ex, num, right, coef);
+  }
+  return false;
 }
 
-/* Goto a label under all conditions, no check needed.
+/* Rough cost of computing an expression once, counting a
+ * multiplication as MULT_COST like genRepeatAdd does.
  */
-void genGoto(Node* node)
+int exprCost(Node* node)
 {
-  outFile << "BR " << node->token1.tokenString << endl;
+  exprType type = getType(node);
+  if(type == LEAF_ex)
+  {
+    return 1;
+  }
+  if(type == PASS_ex)
+  {
+    return exprCost(node->child1);
+  }
+  if(type == NEG_ex)
+  {
+    return exprCost(node->child1) + MULT_COST;
+  }
+  int op = type == MULT_ex || type == DIV_ex ? MULT_COST : 1;
+  int right = getType(node->child2) == LEAF_ex ? 0 : exprCost(node->child2) + 1;
+  return exprCost(node->child1) + right + op;
 }
 
-/* With only one child, simply call the child's function.
- * With two children, store right side in a temporary
- * variable and subtract from result of left side with it.
- * Does not result variable counter because an unknown
- * number of them are needed.
+/* Advances the temporaries reduced from a variable after it
+ * is stepped, see reduceLoop.
  */
-void genExpr(Node* node)
+void genSteps(string var)
 {
-  if(node->child2)
+  map<string, vector<pair<string, int> > >::iterator it = steps.find(var);
+  if(it == steps.end())
   {
-    genExpr(node->child2);
-    string temp = newName(VAR);
-    outFile << "STORE " << temp << endl;
-    genN(node->child1);
-    outFile << "SUB " << temp << endl;
+    return;
   }
-  else
+  for(unsigned int i = 0; i < it->second.size(); i++)
   {
-    genN(node->child1);
+    stringstream add;
+    add << it->second[i].second;
+    emit("LOAD", it->second[i].first);
+    emit("ADD", add.str());
+    emit("STORE", it->second[i].first);
   }
 }
 
-/* With one child, just call child's function.
- * With either other option, store result of right side
- * in a temporary variable, then divide or multiply - 
- * modify - result of the left side with it.
- * As with <expr>, unknown number of temporary variables
- * are needed so they are not reset.
+/* Recursively looks for the largest invariant expressions under
+ * a node. Leaves are never moved, since loading a temporary costs
+ * the same as loading the variable or integer itself.
  */
-void genN(Node* node)
+void findHoists(Node* node, set<string> &written, vector<Node*> &moved, bool allowDiv)
 {
-  if(node->token1.tokenString.compare("/") == 0)
+  if(!node || hoisted.count(node) > 0)
   {
-    genN(node->child2);
-    string temp = newName(VAR);
-    outFile << "STORE " << temp << endl;
-    genA(node->child1);
-    outFile << "DIV " << temp << endl;
+    return;
   }
-  else if(node->token1.tokenString.compare("*") == 0)
+  bool exprNode = node->label.compare("expr") == 0 || node->label.compare("N") == 0
+               || node->label.compare("A") == 0 || node->label.compare("M") == 0
+               || node->label.compare("R") == 0;
+  if(exprNode && hasOp(node) && isInvariant(node, written)
+     && (allowDiv || !hasDiv(node)))
   {
-    genN(node->child2);
-    string temp = newName(VAR);
-    outFile << "STORE " << temp << endl;
-    genA(node->child1);
-    outFile << "MULT " << temp << endl;
+    hoistExpr(node, moved);
+    return;
   }
-  else
+  findHoists(node->child1, written, moved, allowDiv);
+  findHoists(node->child2, written, moved, allowDiv);
+  findHoists(node->child3, written, moved, allowDiv);
+  findHoists(node->child4, written, moved, allowDiv);
+}
+
+/* Computes an expression into a new temporary variable before
+ * the loop. Temporaries used while computing it are free again
+ * afterwards, only the result has to be kept.
+ * An expression already hoisted by an outer loop is reused.
+ */
+void hoistExpr(Node* node, vector<Node*> &moved)
+{
+  if(hoisted.count(node) > 0)
   {
-    genA(node->child1);
+    return;
   }
+  string temp = newName(VAR);
+  int mark = varCount;
+  genPart(node);
+  emit("STORE", temp);
+  varCount = mark;
+  hoisted.insert(pair<Node*, string>(node, temp));
+  moved.push_back(node);
 }
 
-/* Repeat comments for <expr> and <N>.
- * Use addition instead of other operators.
+/* Shared by <iffy> and <loop>. Leaves the result of the first
+ * expression minus the second in the accumulator for <RO>.
+ * When only the first expression is a single value, such as a
+ * hoisted loop invariant, the second minus the first is computed
+ * instead to save a temporary. Returns true in that case, so
+ * <RO> has to be mirrored.
  */
-void genA(Node* node)
+bool genCond(Node* node)
 {
-  if(node->child2)
+  // Subtracting 0 leaves the other expression as it is.
+  int zero;
+  if(getConst(node->child3, zero) && zero == 0)
   {
-    genA(node->child2);
-    string temp = newName(VAR);
-    outFile << "STORE " << temp << endl;
-    genM(node->child1);
-    outFile << "ADD " << temp << endl;
+    genPart(node->child1);
+    return false;
   }
-  else
+  if(getConst(node->child1, zero) && zero == 0)
+  {
+    genPart(node->child3);
+    return true;
+  }
+  string leaf;
+  if(isLeaf(node->child1, leaf) && !isLeaf(node->child3, leaf))
   {
-    genM(node->child1);
+    genBinary(node->child3, node->child1, "SUB");
+    return true;
   }
+  genBinary(node->child1, node->child3, "SUB");
+  return false;
 }
 
-/* If a token exists, negate (multiply by -1) the value
- * and recursively call on the child. Otherwise,
- * call the child's function.
+/* Add branching instructions based on relational operators.
+ * Expects the result of the second expression in a comparison
+ * to be subtracted from the first.
+ * If the first expression is larger, the value left is positive.
+ * If the first expression is smaller, the value left is negative.
+ * If they are equal, the value left is 0.
+ * Because these labels skip the iffy and loop statements, the
+ * branching instruction should act on the opposite condition.
+ * So for "<<" which does the statement on less than or equal,
+ * only skip when a positive value remains.
+ * When onTrue is set, branch when the condition holds instead.
+ * This is used at the bottom of a rotated loop.
+ * When mirror is set, the first expression was subtracted from
+ * the second instead, so "<" acts as ">" and so on.
  */
-void genM(Node* node)
+void genRO(Node* node, string label, bool onTrue, bool mirror)
 {
-  if(node->token1.tokenString.compare("*") == 0)
+  relType rel = getRel(node);
+  if(mirror)
   {
-    genM(node->child1);
-    outFile << "MULT -1\n";
+    rel = mirrorRel(rel);
   }
-  else
+
+  switch(rel)
   {
-    genR(node->child1);
+  // "<<" less than or equal to
+  case LESSEQ_rel:
+    emit(onTrue ? "BRZNEG" : "BRPOS", label);
+    break;
+  // "<>" not equal to
+  case NOTEQUAL_rel:
+    if(onTrue)
+    {
+      emit("BRNEG", label);
+      emit("BRPOS", label);
+    }
+    else
+    {
+      emit("BRZERO", label);
+    }
+    break;
+  // "<" less than
+  case LESS_rel:
+    emit(onTrue ? "BRNEG" : "BRZPOS", label);
+    break;
+  // ">>" greater than or equal to
+  case GREATEREQ_rel:
+    emit(onTrue ? "BRZPOS" : "BRNEG", label);
+    break;
+  // ">" greater than
+  case GREATER_rel:
+    emit(onTrue ? "BRPOS" : "BRZNEG", label);
+    break;
+  // "==" equal to
+  default:
+    if(onTrue)
+    {
+      emit("BRZERO", label);
+    }
+    else
+    {
+      emit("BRNEG", label);
+      emit("BRPOS", label);
+    }
   }
 }
 
-/* If a child exists, recursively call <expr> to repeat the
- * cycle. If no child exists, load the integer or variable
- * into the accumulator.
+/* True if both expressions of a condition are integers after
+ * simplifying, so whether it holds is known at compile time.
+ * The integers are compared directly, subtracting could overflow.
  */
-void genR(Node* node)
+bool knownCond(Node* node, bool &holds)
 {
-  if(node->child1)
+  int left, right;
+  if(!getConst(node->child1, left) || !getConst(node->child3, right))
   {
-    genExpr(node->child1);
+    return false;
   }
-  else
+  switch(getRel(node->child2))
   {
-    outFile << "LOAD " << node->token1.tokenString << endl;
+  case LESS_rel:
+    holds = left < right;
+    break;
+  case LESSEQ_rel:
+    holds = left <= right;
+    break;
+  case GREATER_rel:
+    holds = left > right;
+    break;
+  case GREATEREQ_rel:
+    holds = left >= right;
+    break;
+  case NOTEQUAL_rel:
+    holds = left != right;
+    break;
+  default:
+    holds = left == right;
   }
+  return true;
 }
 
-/* Add the final STOP to .asm. Loop through all declared
- * and temporary variables with initial values and print
- * to the end of the file.
+/* Reads the relational operator out of the tokens in <RO>.
  */
-void writeFinal()
+relType getRel(Node* node)
 {
-  outFile << "STOP\n";
-  map<string, int>::iterator it = decTemp.begin();
-  while(it != decTemp.end())
+  if(node->token1.tokenString.compare("<") == 0)
   {
-    outFile << it->first << " " << it->second << endl;
+    if(node->token2.tokenString.compare("<") == 0)
+    {
+      return LESSEQ_rel;
+    }
+    else if(node->token2.tokenString.compare(">") == 0)
+    {
+      return NOTEQUAL_rel;
+    }
+    return LESS_rel;
+  }
+  else if(node->token1.tokenString.compare(">") == 0)
+  {
+    if(node->token2.tokenString.compare(">") == 0)
+    {
+      return GREATEREQ_rel;
+    }
+    return GREATER_rel;
+  }
+  return EQUAL_rel;
+}
+
+/* Gives the operator that holds with the two sides swapped.
+ * a < b is the same as b > a. Equality does not change.
+ */
+relType mirrorRel(relType rel)
+{
+  switch(rel)
+  {
+  case LESS_rel:
+    return GREATER_rel;
+  case LESSEQ_rel:
+    return GREATEREQ_rel;
+  case GREATER_rel:
+    return LESS_rel;
+  case GREATEREQ_rel:
+    return LESSEQ_rel;
+  default:
+    return rel;
+  }
+}
+
+/* Value from expression does not need to be saved to a temporary
+ * variable, the variable we want it saved to is given.
+ * Resets the temp variable count like other statements.
+ */
+void genAssign(Node* node)
+{
+  genPart(node->child1);
+  string var = node->token1.tokenString;
+
+  // A value just saved for reuse is kept in the variable instead,
+  // so it is not stored twice. It still holds until the variable
+  // or anything it was computed from is written.
+  string saved = "";
+  if(code.back().op.compare("STORE") == 0 && code.back().arg[0] == '#')
+  {
+    saved = code.back().arg;
+    code.pop_back();
+  }
+  emit("STORE", var);
+  forgetVar(var);
+  map<string, cseEntry>::iterator it = available.begin();
+  for(; !saved.empty() && it != available.end(); it++)
+  {
+    if(it->second.temp.compare(saved) == 0)
+    {
+      it->second.temp = var;
+      it->second.vars.insert(var);
+    }
+  }
+  genSteps(var);
+  varCount = varFloor;
+}
+
+/* Set up a label with no actual instruction, for goto statements.
+ */
+void genLabel(Node* node)
+{
+  emitLabel(node->token1.tokenString);
+}
+
+/* Goto a label under all conditions, no check needed.
+ */
+void genGoto(Node* node)
+{
+  emit("BR", node->token1.tokenString);
+}
+
+/* With only one child, simply call the child's function.
+ * With two children, subtract the right side from the left
+ * side, see genBinary for the order they are computed in.
+ */
+void genExpr(Node* node)
+{
+  if(genHoisted(node))
+  {
+    return;
+  }
+  if(node->child2)
+  {
+    genBinary(node->child1, node->child2, "SUB");
+  }
+  else
+  {
+    genPart(node->child1);
+  }
+}
+
+/* With one child, just call child's function.
+ * With either other option, divide or multiply - modify -
+ * the result of the left side with the right side.
+ */
+void genN(Node* node)
+{
+  if(genHoisted(node))
+  {
+    return;
+  }
+  if(node->token1.tokenString.compare("/") == 0)
+  {
+    genBinary(node->child1, node->child2, "DIV");
+  }
+  else if(node->token1.tokenString.compare("*") == 0)
+  {
+    genBinary(node->child1, node->child2, "MULT");
+  }
+  else
+  {
+    genPart(node->child1);
+  }
+}
+
+/* Repeat comments for <expr> and <N>.
+ * Use addition instead of other operators.
+ */
+void genA(Node* node)
+{
+  if(genHoisted(node))
+  {
+    return;
+  }
+  if(node->child2)
+  {
+    genBinary(node->child1, node->child2, "ADD");
+  }
+  else
+  {
+    genPart(node->child1);
+  }
+}
+
+/* Generates left op right for any binary operator, using
+ * Sethi-Ullman ordering to keep as few temporaries live as possible.
+ * A leaf on the right (a variable, integer, or hoisted value) is used
+ * directly as the argument and needs no temporary. A leaf on the left
+ * works the same way for ADD and MULT, and for SUB by negating
+ * right - left afterwards. Otherwise the side needing more temporaries
+ * is computed first and stored while the other side is computed.
+ * DIV cannot be turned around, so its right side always goes first.
+ * Temporaries are freed as soon as they are used, so later
+ * subexpressions in the same statement reuse them.
+ */
+void genBinary(Node* left, Node* right, string op)
+{
+  string leaf;
+  bool reverses = op.compare("DIV") != 0;
+  if(op.compare("MULT") == 0 && isLeaf(right, leaf) && !isVariable(leaf)
+     && genRepeatAdd(left, atoi(leaf.c_str())))
+  {
+    return;
+  }
+  if(isLeaf(right, leaf))
+  {
+    genPart(left);
+    emit(op, leaf);
+    return;
+  }
+  if(reverses && isLeaf(left, leaf))
+  {
+    genPart(right);
+    emit(op, leaf);
+    if(op.compare("SUB") == 0)
+    {
+      emit("MULT", "-1");
+    }
+    return;
+  }
+
+  bool leftFirst = reverses && getNeed(left) > getNeed(right);
+  Node* first = leftFirst ? left : right;
+  Node* second = leftFirst ? right : left;
+  genPart(first);
+  string temp = newName(VAR);
+  emit("STORE", temp);
+  genPart(second);
+  emit(op, temp);
+  if(leftFirst && op.compare("SUB") == 0)
+  {
+    emit("MULT", "-1");
+  }
+  // The temporary is dead now, hand it back.
+  varCount--;
+}
+
+/* Strength reduction for multiplying by a small integer. Adds the
+ * left side to itself instead when that costs less than MULT.
+ * A single value is added directly, anything else is stored in a
+ * temporary first, which costs one more instruction.
+ * Returns false without generating anything if MULT is cheaper.
+ */
+bool genRepeatAdd(Node* left, int times)
+{
+  string base;
+  bool leaf = isLeaf(left, base);
+  int adds = times - 1;
+  if(times < 2 || adds + (leaf ? 0 : 1) >= MULT_COST)
+  {
+    return false;
+  }
+
+  genPart(left);
+  if(!leaf)
+  {
+    base = newName(VAR);
+    emit("STORE", base);
+  }
+  for(int i = 0; i < adds; i++)
+  {
+    emit("ADD", base);
+  }
+  if(!leaf)
+  {
+    varCount--;
+  }
+  return true;
+}
+
+/* Number of temporaries needed to compute an expression into the
+ * accumulator, following the choices made in genBinary.
+ * Results are kept since genBinary asks again at every level.
+ */
+int getNeed(Node* node)
+{
+  string leaf;
+  if(!node || isLeaf(node, leaf))
+  {
+    return 0;
+  }
+  map<Node*, int>::iterator it = needs.find(node);
+  if(it != needs.end())
+  {
+    return it->second;
+  }
+
+  int need = 0;
+  bool binary = node->label.compare("R") != 0 && node->label.compare("M") != 0
+                && !node->token1.tokenString.empty();
+  if(!binary)
+  {
+    need = getNeed(node->child1);
+  }
+  else
+  {
+    Node* left = node->child1;
+    Node* right = node->child2;
+    bool reverses = node->token1.tokenString.compare("/") != 0;
+    int leftNeed = getNeed(left);
+    int rightNeed = getNeed(right);
+    if(isLeaf(right, leaf))
+    {
+      need = leftNeed;
+    }
+    else if(reverses && isLeaf(left, leaf))
+    {
+      need = rightNeed;
+    }
+    else if(reverses && leftNeed > rightNeed)
+    {
+      need = max(leftNeed, rightNeed + 1);
+    }
+    else
+    {
+      need = max(rightNeed, leftNeed + 1);
+    }
+  }
+  needs.insert(pair<Node*, int>(node, need));
+  return need;
+}
+
+/* True if an expression is a single value that can be used directly
+ * as an argument: a variable, an integer, a hoisted expression, or
+ * an expression already saved in this block.
+ * Sets leaf to that argument.
+ */
+bool isLeaf(Node* node, string &leaf)
+{
+  while(node)
+  {
+    map<Node*, string>::iterator it = hoisted.find(node);
+    if(it != hoisted.end())
+    {
+      leaf = it->second;
+      return true;
+    }
+    if(hasOp(node))
+    {
+      map<string, cseEntry>::iterator saved = available.find(getKey(node));
+      if(saved != available.end())
+      {
+        leaf = saved->second.temp;
+        return true;
+      }
+    }
+    if(node->label.compare("R") == 0 && !node->child1)
+    {
+      leaf = node->token1.tokenString;
+      return true;
+    }
+    // Any operator means more than one value.
+    if(node->label.compare("R") != 0 && !node->token1.tokenString.empty())
+    {
+      return false;
+    }
+    node = node->child1;
+  }
+  return false;
+}
+
+/* If a token exists, negate (multiply by -1) the value
+ * and recursively call on the child. Otherwise,
+ * call the child's function.
+ */
+void genM(Node* node)
+{
+  if(genHoisted(node))
+  {
+    return;
+  }
+  if(node->token1.tokenString.compare("*") == 0)
+  {
+    genPart(node->child1);
+    emit("MULT", "-1");
+  }
+  else
+  {
+    genPart(node->child1);
+  }
+}
+
+/* If a child exists, recursively call <expr> to repeat the
+ * cycle. If no child exists, load the integer or variable
+ * into the accumulator.
+ */
+void genR(Node* node)
+{
+  if(genHoisted(node))
+  {
+    return;
+  }
+  if(node->child1)
+  {
+    genPart(node->child1);
+  }
+  else
+  {
+    emit("LOAD", node->token1.tokenString);
+  }
+}
+
+/* Loads the temporary holding a hoisted loop invariant expression.
+ * Returns false if the expression was not hoisted.
+ */
+bool genHoisted(Node* node)
+{
+  map<Node*, string>::iterator it = hoisted.find(node);
+  if(it == hoisted.end())
+  {
+    return false;
+  }
+  emit("LOAD", it->second);
+  return true;
+}
+
+/* Calls the code generating function matching the label of
+ * any node from <expr> down to <R>.
+ * Expressions with an operator are looked up first and loaded
+ * if already computed in this block, otherwise saved afterwards.
+ */
+void genPart(Node* node)
+{
+  string leaf;
+  bool save = hasOp(node);
+  if(save && isLeaf(node, leaf))
+  {
+    emit("LOAD", leaf);
+    return;
+  }
+
+  if(node->label.compare("expr") == 0)
+  {
+    genExpr(node);
+  }
+  else if(node->label.compare("N") == 0)
+  {
+    genN(node);
+  }
+  else if(node->label.compare("A") == 0)
+  {
+    genA(node);
+  }
+  else if(node->label.compare("M") == 0)
+  {
+    genM(node);
+  }
+  else
+  {
+    genR(node);
+  }
+
+  if(save)
+  {
+    stringstream name;
+    name << "#" << cseCount++;
+    cseEntry entry;
+    entry.temp = name.str();
+    findReads(node, entry.vars);
+    available.insert(pair<string, cseEntry>(getKey(node), entry));
+    emit("STORE", entry.temp);
+  }
+}
+
+/* Builds text for an expression that is the same for any two
+ * expressions computing the same value, with the sides of + and *
+ * sorted since they commute. Used as the value number.
+ */
+string getKey(Node* node)
+{
+  map<Node*, string>::iterator it = keys.find(node);
+  if(it != keys.end())
+  {
+    return it->second;
+  }
+
+  string key;
+  map<Node*, string>::iterator moved = hoisted.find(node);
+  if(moved != hoisted.end())
+  {
+    key = moved->second;
+  }
+  else if(node->label.compare("R") == 0 && !node->child1)
+  {
+    key = node->token1.tokenString;
+  }
+  else if(node->label.compare("R") == 0 || node->token1.tokenString.empty())
+  {
+    key = getKey(node->child1);
+  }
+  else if(node->label.compare("M") == 0)
+  {
+    key = "*(" + getKey(node->child1) + ")";
+  }
+  else
+  {
+    string op = node->label.compare("expr") == 0 ? "-" : node->token1.tokenString;
+    string left = getKey(node->child1);
+    string right = getKey(node->child2);
+    if(op.compare("-") != 0 && op.compare("/") != 0 && right < left)
+    {
+      left.swap(right);
+    }
+    key = "(" + left + op + right + ")";
+  }
+  keys.insert(pair<Node*, string>(node, key));
+  return key;
+}
+
+/* Forgets every saved value computed from a variable that
+ * was just written.
+ */
+void forgetVar(string var)
+{
+  map<string, cseEntry>::iterator it = available.begin();
+  while(it != available.end())
+  {
+    if(it->second.vars.count(var) > 0)
+    {
+      available.erase(it++);
+    }
+    else
+    {
+      it++;
+    }
+  }
+}
+
+/* Gives saved values their real temporary variable names, numbered
+ * after every temporary used by expressions so none can clash.
+ */
+void nameSaved()
+{
+  for(unsigned int i = 0; i < code.size(); i++)
+  {
+    if(!code[i].arg.empty() && code[i].arg[0] == '#')
+    {
+      stringstream name;
+      name << "T" << maxVar + atoi(code[i].arg.substr(1).c_str());
+      code[i].arg = name.str();
+      decTemp.insert(pair<string, int>(name.str(), 0));
+    }
+  }
+}
+
+/* Generates the statements of a segment of the outer block on the
+ * calling thread, starting from nothing as the first statement of a
+ * program does. Labels are numbered from the range reserved for the
+ * segment, and saved values from #0 until joinSegment moves them.
+ */
+void genSegmentCode(genSegment &segment)
+{
+  code.clear();
+  decTemp.clear();
+  remarks.clear();
+  available.clear();
+  labelCount = segment.firstLabel;
+  varCount = VAR_DEFAULT;
+  varFloor = VAR_DEFAULT;
+  t0out = true;
+  cseCount = 0;
+  maxVar = VAR_DEFAULT;
+  curLine = 0;
+  for(unsigned int i = 0; i < segment.stats.size(); i++)
+  {
+    recGen(segment.stats[i]);
+  }
+  segment.code.swap(code);
+  segment.temps.swap(decTemp);
+  segment.remarks.swap(remarks);
+  segment.used = labelCount - segment.firstLabel;
+  segment.saved = cseCount;
+  segment.maxVar = maxVar;
+}
+
+/* Adds a generated segment to the end of the code, as if its
+ * statements were generated here. Saved values are numbered after
+ * those of the segments before it.
+ */
+void joinSegment(genSegment &segment)
+{
+  for(unsigned int i = 0; i < segment.code.size(); i++)
+  {
+    asmLine &line = segment.code[i];
+    if(!line.arg.empty() && line.arg[0] == '#')
+    {
+      stringstream name;
+      name << "#" << cseCount + atoi(line.arg.substr(1).c_str());
+      line.arg = name.str();
+    }
+    code.push_back(line);
+  }
+  decTemp.insert(segment.temps.begin(), segment.temps.end());
+  remarks.insert(remarks.end(), segment.remarks.begin(), segment.remarks.end());
+  labelCount += segment.used;
+  cseCount += segment.saved;
+  maxVar = max(maxVar, segment.maxVar);
+  t0out = decTemp.find("T0") == decTemp.end();
+}
+
+/* Number of labels newName gives while generating a subtree,
+ * following the same choices as genIffy and genLoop.
+ */
+int countLabels(Node* node)
+{
+  if(!node)
+  {
+    return 0;
+  }
+  bool iffy = node->label.compare("iffy") == 0;
+  bool loop = node->label.compare("loop") == 0;
+  bool holds;
+  bool known = (iffy || loop) && knownCond(node, holds);
+  if(iffy || (loop && known && !holds))
+  {
+    if(known && (holds || !hasLabel(node->child4)))
+    {
+      return holds ? countLabels(node->child4) : 0;
+    }
+    return 1 + countLabels(node->child4);
+  }
+  if(loop)
+  {
+    int trips;
+    int copies = 1;
+    bool unrolled = getUnroll(node, trips, copies);
+    int body = countLabels(node->child4);
+    if(unrolled && copies == trips)
+    {
+      return trips * body;
+    }
+    if(known)
+    {
+      return 1 + body;
+    }
+    return 2 + body * (copies + (unrolled ? trips % copies : 0));
+  }
+  return countLabels(node->child1) + countLabels(node->child2)
+       + countLabels(node->child3) + countLabels(node->child4);
+}
+
+/* True if nothing saved is known to hold once a statement has been
+ * generated, since the last thing it does is set a label. The next
+ * statement then starts the same as the first of a program.
+ */
+bool endsClear(Node* node)
+{
+  if(!node)
+  {
+    return false;
+  }
+  if(node->label.compare("stat") == 0)
+  {
+    return endsClear(node->child1);
+  }
+  if(node->label.compare("label") == 0)
+  {
+    return true;
+  }
+  if(node->label.compare("block") == 0)
+  {
+    Node* last = node->child2 ? node->child2 : node->child1;
+    while(last && last->child2)
+    {
+      last = last->child2;
+    }
+    return last && endsClear(last->child1);
+  }
+  bool iffy = node->label.compare("iffy") == 0;
+  bool loop = node->label.compare("loop") == 0;
+  bool holds;
+  bool known = (iffy || loop) && knownCond(node, holds);
+  if(iffy || (loop && known && !holds))
+  {
+    if(known && (holds || !hasLabel(node->child4)))
+    {
+      return holds && endsClear(node->child4);
+    }
+    return true;
+  }
+  if(loop)
+  {
+    int trips;
+    int copies = 1;
+    if(getUnroll(node, trips, copies) && copies == trips)
+    {
+      return trips > 0 && endsClear(node->child4);
+    }
+    // Never ends unless a goto leaves, the last thing is the BR back.
+    return !known;
+  }
+  return false;
+}
+
+/* Collects every variable an expression reads.
+ */
+void findReads(Node* node, set<string> &vars)
+{
+  if(!node)
+  {
+    return;
+  }
+  if(node->label.compare("R") == 0 && node->token1.id == IDENT_tk)
+  {
+    vars.insert(node->token1.tokenString);
+  }
+  findReads(node->child1, vars);
+  findReads(node->child2, vars);
+}
+
+/* Collects every variable a subtree may write to,
+ * from <assign> and <in>.
+ */
+void findWrites(Node* node, set<string> &written)
+{
+  if(!node)
+  {
+    return;
+  }
+  if(node->label.compare("assign") == 0 || node->label.compare("in") == 0)
+  {
+    written.insert(node->token1.tokenString);
+  }
+  findWrites(node->child1, written);
+  findWrites(node->child2, written);
+  findWrites(node->child3, written);
+  findWrites(node->child4, written);
+}
+
+/* True if a subtree contains a <label> statement.
+ */
+bool hasLabel(Node* node)
+{
+  if(!node)
+  {
+    return false;
+  }
+  return node->label.compare("label") == 0 || hasLabel(node->child1)
+      || hasLabel(node->child2) || hasLabel(node->child3) || hasLabel(node->child4);
+}
+
+/* True if an expression only reads variables outside of written.
+ * Already hoisted expressions count as invariant.
+ */
+bool isInvariant(Node* node, set<string> &written)
+{
+  if(!node || hoisted.count(node) > 0)
+  {
+    return true;
+  }
+  if(node->label.compare("R") == 0 && node->token1.id == IDENT_tk
+     && written.count(node->token1.tokenString) > 0)
+  {
+    return false;
+  }
+  return isInvariant(node->child1, written) && isInvariant(node->child2, written)
+      && isInvariant(node->child3, written) && isInvariant(node->child4, written);
+}
+
+/* True if an expression has any operator in it. Tokens in <R>
+ * are the variable or integer, every other token is an operator.
+ */
+bool hasOp(Node* node)
+{
+  if(!node)
+  {
+    return false;
+  }
+  if(node->label.compare("R") != 0 && !node->token1.tokenString.empty())
+  {
+    return true;
+  }
+  return hasOp(node->child1) || hasOp(node->child2);
+}
+
+/* True if an expression multiplies anywhere, not counting negation.
+ */
+bool hasMult(Node* node)
+{
+  if(!node)
+  {
+    return false;
+  }
+  if(node->label.compare("N") == 0 && node->token1.tokenString.compare("*") == 0)
+  {
+    return true;
+  }
+  return hasMult(node->child1) || hasMult(node->child2);
+}
+
+/* True if an expression divides anywhere.
+ */
+bool hasDiv(Node* node)
+{
+  if(!node)
+  {
+    return false;
+  }
+  if(node->label.compare("N") == 0 && node->token1.tokenString.compare("/") == 0)
+  {
+    return true;
+  }
+  return hasDiv(node->child1) || hasDiv(node->child2);
+}
+
+/* Write every generated line to .asm, ending with the STOP
+ * added by codeGeneration. Loop through all declared and
+ * temporary variables with initial values and print
+ * to the end of the file.
+ * Bytecode output resolves the lines first, see bytecode.cpp.
+ */
+void writeFinal()
+{
+  if(emitMode == BYTECODE_emit)
+  {
+    program prog;
+    loadLines(code, decTemp, prog);
+    writeBytecode(outFile, prog);
+    return;
+  }
+  if(emitMode == NATIVE_emit)
+  {
+    program prog;
+    loadLines(code, decTemp, prog);
+    writeNative(outFile, prog);
+    return;
+  }
+  for(unsigned int i = 0; i < code.size(); i++)
+  {
+    if(!code[i].label.empty())
+    {
+      outFile << code[i].label << ": ";
+    }
+    outFile << code[i].op;
+    if(!code[i].arg.empty())
+    {
+      outFile << " " << code[i].arg;
+    }
+    outFile << endl;
+  }
+  map<string, int>::iterator it = decTemp.begin();
+  while(it != decTemp.end())
+  {
+    outFile << it->first << " " << it->second << endl;
     it++;
   }
 }
+
+/* Writes the .map file for an output file: the source line of
+ * every instruction in order, one per line, 0 where unknown.
+ */
+void writeLineMap(string filename)
+{
+  string name = filename.substr(0, filename.rfind('.')) + ".map";
+  ofstream mapFile(name.c_str());
+  if(!mapFile.is_open())
+  {
+    cout << "Unable to write to " << name << ".\n";
+    exit(1);
+  }
+  for(unsigned int i = 0; i < code.size(); i++)
+  {
+    mapFile << code[i].line << endl;
+  }
+}
+
+/* Gives the generated program as written, already loaded, so it
+ * can be run right after compiling.
+ */
+void finalProgram(program &prog)
+{
+  loadLines(code, decTemp, prog);
+}
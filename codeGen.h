@@ -9,11 +9,43 @@
 #define CODEGEN_H
 
 #include "node.h"
+#include "asmLine.h"
+#include "virtMach.h"
 #include <string>
+#include <set>
+#include <vector>
+#include <map>
 
 typedef enum {VAR, LABEL} nameType;
+typedef enum {ASM_emit, BYTECODE_emit, NATIVE_emit} emitType;
+// Statements of the outer block generated on their own thread,
+// see segments.cpp.
+struct genSegment
+{
+  std::vector<Node*> stats;	// <stat>s in order
+  int firstLabel;		// First label reserved for the segment
+  int labels;			// Labels reserved, from countLabels
+  int used;			// Labels actually given
+  std::vector<asmLine> code;	// Generated lines, saved values from #0
+  std::map<std::string, int> temps;	// Variables declared or used
+  std::vector<std::pair<int, std::string> > remarks;
+  int saved;			// Saved values used
+  int maxVar;			// Highest temporary variable count reached
+};
+
+typedef enum {LESS_rel, LESSEQ_rel, GREATER_rel, GREATEREQ_rel,
+              EQUAL_rel, NOTEQUAL_rel} relType;
 
 void codeGeneration(Node*, std::string);
+void setEvalBudget(long);
+void setEmit(emitType);
+emitType getEmit();
+void setOptRemarks(bool);
+void setLineMap(bool);
+void setSimplified(bool);
+void remark(int, std::string);
+void emit(std::string, std::string = "");
+void emitLabel(std::string);
 std::string newName(nameType);
 void recGen(Node*);
 void genVars(Node*);
@@ -21,16 +53,53 @@ void genIn(Node*);
 void genOut(Node*);
 void genIffy(Node*);
 void genLoop(Node*);
-void genRO(Node*, std::string);
+void genCopies(Node*, int);
+void hoistLoop(Node*, std::vector<Node*> &);
+void reduceLoop(Node*, std::vector<Node*> &, std::vector<std::string> &);
+void findLinear(Node*, std::string, std::set<std::string> &, std::vector<std::string> &,
+                std::map<std::string, std::vector<Node*> > &);
+bool linearCoef(Node*, std::string, std::set<std::string> &, int &);
+int exprCost(Node*);
+void genSteps(std::string);
+void findHoists(Node*, std::set<std::string> &, std::vector<Node*> &, bool);
+void hoistExpr(Node*, std::vector<Node*> &);
+bool genCond(Node*);
+void genRO(Node*, std::string, bool = false, bool = false);
+bool knownCond(Node*, bool &);
+relType getRel(Node*);
+relType mirrorRel(relType);
 void genAssign(Node*);
 void genLabel(Node*);
 void genGoto(Node*);
 void genExpr(Node*);
 void genN(Node*);
 void genA(Node*);
+void genBinary(Node*, Node*, std::string);
+bool genRepeatAdd(Node*, int);
+int getNeed(Node*);
+bool isLeaf(Node*, std::string &);
 void genM(Node*);
 void genR(Node*);
 
+bool genHoisted(Node*);
+void genPart(Node*);
+std::string getKey(Node*);
+void forgetVar(std::string);
+void nameSaved();
+void genSegmentCode(genSegment &);
+void joinSegment(genSegment &);
+int countLabels(Node*);
+bool endsClear(Node*);
+void findReads(Node*, std::set<std::string> &);
+void findWrites(Node*, std::set<std::string> &);
+bool hasLabel(Node*);
+bool isInvariant(Node*, std::set<std::string> &);
+bool hasOp(Node*);
+bool hasMult(Node*);
+bool hasDiv(Node*);
+
 void writeFinal();
+void writeLineMap(std::string);
+void finalProgram(program &);
 
 #endif
@@ -0,0 +1,15 @@
+LOAD 1
+STORE x
+WRITE x
+LOAD 2
+STORE T0
+WRITE T0
+LOAD 3
+STORE T0
+WRITE T0
+LOAD 4
+STORE T0
+WRITE T0
+STOP
+T0 0
+x 2
@@ -0,0 +1,20 @@
+LOAD 1
+STORE T0
+WRITE T0
+LOAD 2
+STORE T0
+WRITE T0
+LOAD 3
+STORE T0
+WRITE T0
+LOAD 4
+STORE T0
+WRITE T0
+LOAD 5
+STORE T0
+WRITE T0
+LOAD 6
+STORE T0
+WRITE T0
+STOP
+T0 0
@@ -0,0 +1,56 @@
+L0: NOOP
+WRITE inner
+LOAD 22
+STORE inner
+WRITE inner
+LOAD 23
+STORE inner
+WRITE inner
+LOAD 24
+STORE inner
+WRITE inner
+WRITE middle
+LOAD 21
+STORE inner
+LOAD 12
+STORE middle
+WRITE inner
+LOAD 22
+STORE inner
+WRITE inner
+LOAD 23
+STORE inner
+WRITE inner
+LOAD 24
+STORE inner
+WRITE inner
+WRITE middle
+LOAD 21
+STORE inner
+LOAD 13
+STORE middle
+WRITE inner
+LOAD 22
+STORE inner
+WRITE inner
+LOAD 23
+STORE inner
+WRITE inner
+LOAD 24
+STORE inner
+WRITE inner
+WRITE middle
+LOAD 21
+STORE inner
+WRITE outer
+LOAD 11
+STORE middle
+LOAD outer
+ADD 1
+STORE outer
+SUB 2
+BRZNEG L0
+STOP
+inner 21
+middle 11
+outer 1
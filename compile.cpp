@@ -3,7 +3,48 @@
  * Due Date: 5/14/2020
  *
  * Usage:
- * comp [file]
+ * comp [options] [file]
+ * comp --run-batch [options] file inputs [-j N]
+ *
+ * Options:
+ * --partial-eval[=N]  Run programs that never read input at compile
+ *                     time for up to N instructions (default 10000000).
+ *                     If they finish, only the WRITEs of the output
+ *                     are generated.
+ * --emit=FORM        Write asm text (default) or bytecode, the binary
+ *                     form in bytecode.cpp, to file.vmb instead.
+ * --target=MACHINE    Generate for vm (default), VirtMach, or for
+ *                     x86_64, writing GNU assembler to file.s that
+ *                     links without a C library, see native.cpp.
+ * --opt-remarks       Print which loops were unrolled and why others
+ *                     were not, by source line.
+ * --line-map          Also write file.map with the source line of every
+ *                     instruction, used by vmsim -p.
+ * --unroll-budget=N   Let unrolled loops grow to about N instructions
+ *                     (default 128). 0 turns unrolling off.
+ * --unroll-factor=N   Copy a body at most N times inside a loop that
+ *                     is too large to unroll fully (default 4).
+ * --run-batch         After compiling, run the program once for every
+ *                     file in the inputs directory, reading its input
+ *                     from that file, on N worker threads (default one
+ *                     per processor). Outputs are written in the order
+ *                     of the file names, see runner.cpp.
+ * --pipeline          Scan, parse, and check semantics on three threads
+ *                     at once, see pipeline.cpp. Output is the same.
+ * --parallel-lex[=N]  Scan the file in N chunks at once (default one
+ *                     per processor, for files of 1 MB a chunk), see
+ *                     chunks.cpp. Output is the same.
+ * --parallel-parse[=N] Parse the statements of the outer block on N
+ *                     threads at once (default one per processor, for
+ *                     4096 tokens a thread), see blocks.cpp. Output is
+ *                     the same.
+ * --parallel-gen[=N]  Generate code for the statements of the outer
+ *                     block on N threads at once (default one per
+ *                     processor, for 256 statements a thread), see
+ *                     segments.cpp. Output is the same.
+ * --ll-parser         Parse with tables built from grammar.ll in place
+ *                     of recursive descent, see llParser.cpp. Output is
+ *                     the same. Not with --pipeline or --parallel-parse.
  *
  * Scans a file as part of the compilation process.
  * Whitespace is not required to separate tokens.
@@ -24,13 +65,22 @@
  * move on to code generation.
  */
 
+// These come first since the program() of parser.h would hide
+// the VirtMach program type they use.
+#include "codeGen.h"
+#include "runner.h"
 #include "token.h"
 #include "parser.h"
+#include "pipeline.h"
+#include "chunks.h"
+#include "blocks.h"
+#include "segments.h"
+#include "llParser.h"
 #include "scanner.h"
 #include "lib.h"
 #include "node.h"
 #include "semantics.h"
-#include "codeGen.h"
+#include "unroll.h"
 #include <iostream>
 #include <string>
 #include <stdio.h>
@@ -44,18 +94,47 @@ int main(int argc, char *argv[])
   string filename = "";
   FILE *input = handleArgs(argc, argv, filename);
   setInput(input);
-  filename += ".asm";
+  emitType mode = getEmit();
+  filename += mode == BYTECODE_emit ? ".vmb" : mode == NATIVE_emit ? ".s" : ".asm";
+
+  // Scan the whole file up front when lexing or parsing in parallel,
+  // in one chunk if only parsing is.
+  if(getParallelParse() != 0 && getParallelLex() == 0)
+  {
+    setParallelLex(1);
+  }
+  if(getParallelLex() != 0)
+  {
+    lexFile();
+  }
+  if(getParallelParse() != 0)
+  {
+    parseAhead();
+  }
 
-  // Get root node for a parse tree.
-  Node* root = parser();
-  // Test for success or failure on semantics and output to user.
-  bool testSem = checkSemantics(root);
+  // Get root node for a parse tree, and test for success or failure
+  // on semantics. The pipeline does both at once.
+  Node* root = NULL;
+  bool testSem = false;
+  if(getPipeline())
+  {
+    root = pipelineFront(testSem);
+  }
+  else
+  {
+    root = getTableParser() ? llParser() : parser();
+    testSem = checkSemantics(root);
+  }
   // Generate code on success and output success message.
   // Allows program to end without comment if there are semantics errors.
   if(testSem)
   {
     codeGeneration(root, filename);
     cout << filename << " generated.\n";
+    if(getRunBatch())
+    {
+      runInputs(cout);
+    }
   }
 
   // Close file if file pointer sees it
@@ -69,7 +148,9 @@ int main(int argc, char *argv[])
 }
 
 /* Accepts command line arguments and handles changes in program accordingly.
- * No more than one extra argument is allowed.
+ * Arguments starting with -- are options, handled in handleOption.
+ * No more than one other argument, the file, is allowed, except
+ * that --run-batch takes the file, the inputs directory, and -j N.
  * If the file has the implicit extension, it will be stripped here.
  * Returns a file pointer to the file or stdin for funneled input.
  * Provides a generic filename if none was provided.
@@ -78,12 +159,64 @@ FILE *handleArgs(int argc, char* argv[], string &filename)
 {
   // Sets a file pointer, either for stdin or a file
   FILE* input = NULL;
+  int files = 0;
+  string inputs = "";
 
-  if(argc == 2)
+  for(int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if(arg.compare(0, 2, "--") == 0)
+    {
+      handleOption(arg);
+    }
+    else if(arg.compare("-j") == 0)
+    {
+      string count = i + 1 < argc ? argv[++i] : "";
+      if(count.empty() || count.find_first_not_of("0123456789") != string::npos
+         || atoi(count.c_str()) <= 0)
+      {
+        cout << "Error: -j needs a positive number of workers.\n";
+        exit(1);
+      }
+      setJobs(atoi(count.c_str()));
+    }
+    else if(files == 1 && inputs.empty())
+    {
+      inputs = arg;
+      files++;
+    }
+    else
+    {
+      filename = arg;
+      files++;
+    }
+  }
+
+  // The table parser takes every token itself, with nothing parsed
+  // ahead of it or handed to another thread.
+  if(getTableParser() && (getPipeline() || getParallelParse() != 0))
+  {
+    cout << "Error: --ll-parser cannot be used with --pipeline or --parallel-parse.\n";
+    exit(1);
+  }
+
+  // The inputs directory only comes after the file with --run-batch.
+  if(getRunBatch())
+  {
+    if(files != 2)
+    {
+      cout << "Error: --run-batch needs a file and an inputs directory.\n";
+      cout << "usage: comp --run-batch [options] file inputs [-j N]\n";
+      exit(1);
+    }
+    setInputDir(inputs);
+    files = 1;
+  }
+
+  if(files == 1)
   {
     // If an argument was passed, it is expected to be a filename.
     // Check for the implicit file extension. If it is not present, add it.
-    filename = argv[1];
     string extension = ".sp2020";
     string fullFile = "";
 
@@ -109,14 +242,14 @@ FILE *handleArgs(int argc, char* argv[], string &filename)
     if(input == NULL)
     {
       cout << "Unable to open file " << fullFile << endl;
-      cout << "Usage: comp [file]" << endl;
+      cout << "Usage: comp [options] [file]" << endl;
       exit(1);
     }
   }
 
   // If no arguments were passed, handle input funneled from a file.
   // Sets file pointer to standard input
-  else if(argc == 1)
+  else if(files == 0)
   {
     filename = "kb";
     input = stdin;
@@ -130,7 +263,7 @@ FILE *handleArgs(int argc, char* argv[], string &filename)
   else
   {
     cout << "Error: Unexpected number of arguments.\n";
-    cout << "usage: comp [file]\n";
+    cout << "usage: comp [options] [file]\n";
     exit(1);
   }
 
@@ -147,3 +280,131 @@ FILE *handleArgs(int argc, char* argv[], string &filename)
 
   return input;
 }
+
+/* Sets up a single option given on the command line.
+ * Unknown options print usage and exit.
+ */
+void handleOption(string option)
+{
+  if(option.compare("--partial-eval") == 0)
+  {
+    setEvalBudget(10000000);
+  }
+  else if(option.compare(0, 15, "--partial-eval=") == 0)
+  {
+    long budget = atol(option.substr(15).c_str());
+    if(budget <= 0)
+    {
+      cout << "Error: --partial-eval needs a positive instruction budget.\n";
+      exit(1);
+    }
+    setEvalBudget(budget);
+  }
+  else if(option.compare("--emit=asm") == 0)
+  {
+    setEmit(ASM_emit);
+  }
+  else if(option.compare("--emit=bytecode") == 0)
+  {
+    setEmit(BYTECODE_emit);
+  }
+  else if(option.compare("--target=vm") == 0)
+  {
+    if(getEmit() == NATIVE_emit)
+    {
+      setEmit(ASM_emit);
+    }
+  }
+  else if(option.compare("--target=x86_64") == 0)
+  {
+    setEmit(NATIVE_emit);
+  }
+  else if(option.compare("--opt-remarks") == 0)
+  {
+    setOptRemarks(true);
+  }
+  else if(option.compare("--run-batch") == 0)
+  {
+    setRunBatch(true);
+  }
+  else if(option.compare("--parallel-lex") == 0)
+  {
+    setParallelLex(-1);
+  }
+  else if(option.compare(0, 15, "--parallel-lex=") == 0)
+  {
+    int chunks = atoi(option.substr(15).c_str());
+    if(chunks <= 0 || option.find_first_not_of("0123456789", 15) != string::npos)
+    {
+      cout << "Error: --parallel-lex needs a positive number of chunks.\n";
+      exit(1);
+    }
+    setParallelLex(chunks);
+  }
+  else if(option.compare("--parallel-parse") == 0)
+  {
+    setParallelParse(-1);
+  }
+  else if(option.compare(0, 17, "--parallel-parse=") == 0)
+  {
+    int threads = atoi(option.substr(17).c_str());
+    if(threads <= 0 || option.find_first_not_of("0123456789", 17) != string::npos)
+    {
+      cout << "Error: --parallel-parse needs a positive number of threads.\n";
+      exit(1);
+    }
+    setParallelParse(threads);
+  }
+  else if(option.compare("--parallel-gen") == 0)
+  {
+    setParallelGen(-1);
+  }
+  else if(option.compare(0, 15, "--parallel-gen=") == 0)
+  {
+    int threads = atoi(option.substr(15).c_str());
+    if(threads <= 0 || option.find_first_not_of("0123456789", 15) != string::npos)
+    {
+      cout << "Error: --parallel-gen needs a positive number of threads.\n";
+      exit(1);
+    }
+    setParallelGen(threads);
+  }
+  else if(option.compare("--pipeline") == 0)
+  {
+    setPipeline(true);
+  }
+  else if(option.compare("--ll-parser") == 0)
+  {
+    setTableParser(true);
+  }
+  else if(option.compare("--line-map") == 0)
+  {
+    setLineMap(true);
+  }
+  else if(option.compare(0, 16, "--unroll-budget=") == 0)
+  {
+    string value = option.substr(16);
+    if(value.empty() || value.find_first_not_of("0123456789") != string::npos)
+    {
+      cout << "Error: --unroll-budget needs a size of 0 or more.\n";
+      exit(1);
+    }
+    setUnrollBudget(atoi(value.c_str()));
+  }
+  else if(option.compare(0, 16, "--unroll-factor=") == 0)
+  {
+    int factor = atoi(option.substr(16).c_str());
+    if(factor <= 0 || option.find_first_not_of("0123456789", 16) != string::npos)
+    {
+      cout << "Error: --unroll-factor needs a positive number of copies.\n";
+      exit(1);
+    }
+    setUnrollFactor(factor);
+  }
+  else
+  {
+    cout << "Error: Unknown option " << option << endl;
+    cout << "usage: comp [options] [file]\n";
+    exit(1);
+  }
+}
@@ -10,6 +10,10 @@
  *
  * TOKEN_NUM corresponds to the number of tokenId enum values
  * in token.h.
+ *
+ * Lines and columns are not counted here. A token keeps how far
+ * into the input it was built, and errors look up the line and
+ * column of a character from its offset, see scanner.cpp.
  */
 
 #include "token.h"
@@ -17,6 +21,7 @@
 #include "fsa.h"
 #include "driver.h"
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <stdlib.h>
 using namespace std;
@@ -41,9 +46,10 @@ static string errorNames[ERROR_NUM] = {"Alphabet", "Equal"};
 // Change with token.h if needed. Stores number of tokenId values.
 // Used for building EOF token.
 static const int TOKEN_NUM = 35;
-static string tokenString = ""; // Stores string to place into token
-static int lineNum = 1; // Track line number of input file using newlines
-static int columnNum = 0; // Track column number of input text for errors
+// State for the input file. Threads lexing part of a file point
+// lex at a lexState of their own, see chunks.cpp.
+static lexState fileState = {"", false, false, printNotice};
+static __thread lexState *lex = &fileState;
 
 /* Requests characters from scanner and checks against
  * fsa to build a token's string. When complete, calls
@@ -79,17 +85,16 @@ token getToken()
   while(currentChar > -1)
   {
     // Adds new characters to the string one by one
-    tokenString += static_cast<char>(currentChar);
+    lex->tokenString += static_cast<char>(currentChar);
 
     // If there is an error, send to error handling
     if(currentState < 0)
     {
-      handleError(currentState, currentChar);
+      handleError(currentState, currentChar, inputOffset() - 1);
     }
     else if(nextState < 0)
     {
-      columnNum++;
-      handleError(nextState, nextChar);
+      handleError(nextState, nextChar, inputOffset());
     }
 
     // 100 is the first token end state.
@@ -98,7 +103,7 @@ token getToken()
     {
       // Subtracting 100 from state value corresponds to enum tokenId
       token nToken = buildToken(nextState - 100);
-      tokenString = ""; // Reset token string to empty for next token.
+      lex->tokenString = ""; // Reset token string to empty for next token.
       return nToken;
     }
 
@@ -122,7 +127,7 @@ token getToken()
 
   // If file pointer has reached EOF, build a token
   // using EOF_tk from enum token and return it.
-  tokenString = "EOF";
+  lex->tokenString = "EOF";
   return buildToken(TOKEN_NUM - 1);
 }
 
@@ -135,8 +140,8 @@ token buildToken(int state)
   token nToken;
   
   nToken.id = static_cast<tokenID>(state);
-  nToken.tokenString = tokenString;
-  nToken.lineNum = lineNum;
+  nToken.tokenString = lex->tokenString;
+  nToken.offset = inputOffset();
 
   // Only changes token id to keyword if it was an identifier
   // and passes the keyword test function.
@@ -190,8 +195,8 @@ void checkOperator(token &nToken)
 int filterInput()
 {
   int ch = getChar();
-  bool comment = false;
-  columnNum++;
+  bool comment = lex->comment;
+  lex->comment = false;
 
   // Requests more characters as long as the last was
   // whitespace, a # marking the start or end of a comment,
@@ -199,28 +204,24 @@ int filterInput()
   // Nothing in a comment should be checked against the fsa.
   while(isspace(ch) || comment || ch == 35)
   {
-    // Increment line number on newline and carriage return.
-    if(ch == '\n' || ch == 13)
-    {
-      lineNum++;
-      columnNum = 0;
-    }
-
     // If a # is found while not in a comment, set it to true and loop.
     // If a # is found while in a comment, set it to false and possibly exit loop.
     if(ch == 35)
     {
       comment = !comment;
     }
-    columnNum++;
     ch = getChar();
 
     // If a comment does not end before the file, accept EOF token and
-    // warn the user.
+    // warn the user. Part of a file only ends where the next part
+    // goes on with the comment.
     if(ch < 0 && comment)
     {
       comment = false;
-      cout << endl << "WARNING: Comment does not end before end of file.\n\n";
+      if(!lex->partial)
+      {
+        lex->notice("\nWARNING: Comment does not end before end of file.\n\n", false);
+      }
     }
   }
 
@@ -228,54 +229,80 @@ int filterInput()
 }
 
 /* Handle error preparations before printing the error.
- * Will pass the character causing a problem.
+ * Will pass the character causing a problem and its offset.
  */
-void handleError(int state, char ch)
+void handleError(int state, char ch, int offset)
 {
   // Set an error code as an index. Changes -1 and down to 0 and up.
   int errorCode = (state * -1) - 1;
-  int holdCol = columnNum; // Temporarily store column number
   int counter = 0;
 
   // Finish token string without care for errors, to print to user.
   // Will end after 6 more characters or on newline/carriage return.
   while(counter < 6 && lookupChar() != '\n' && lookupChar() != 13)
   {
-    tokenString += static_cast<char>(getChar());
+    lex->tokenString += static_cast<char>(getChar());
     counter++;
   }
 
-  // Reset column number, was incremented during token building
-  columnNum = holdCol;
-
-  // Token string is complete, column number incremented if
-  // error happened on next character instead of current.
-  errorExit(errorCode, ch);
+  // Token string is complete, offset is of the next character
+  // if the error happened on it instead of the current one.
+  errorExit(errorCode, ch, offset);
 }
 
 /* Prints an error message with descriptive information
  * for the user. Includes the token it was trying to build
- * or marks an alphabet error, and prints the line and column number.
+ * or marks an alphabet error, and prints the line and column number
+ * of the character at offset.
  */
-void errorExit(int errorCode, char ch)
+void errorExit(int errorCode, char ch, int offset)
 {
   string errorWord = errorNames[errorCode];
-  cout << endl;
+  stringstream text;
+  text << endl;
 
   if(errorWord.compare("Alphabet") == 0)
   {
-    cout << "SCANNER ERROR: Character '" << ch << "' not in alphabet.\n";
+    text << "SCANNER ERROR: Character '" << ch << "' not in alphabet.\n";
   }
   else if(errorWord.compare("Equal") == 0)
   {
-    cout << "SCANNER ERROR: '=' is not a valid token.\n";
+    text << "SCANNER ERROR: '=' is not a valid token.\n";
   }
   else
   {
-    cout << "SCANNER ERROR: Unknown error. User is not expected to see this.\n";
+    text << "SCANNER ERROR: Unknown error. User is not expected to see this.\n";
   }
-  cout << "     Line: " << lineNum << " Column: " << columnNum;
-  cout << " Context: \"" << tokenString << "\"" << endl << endl;
+  text << "     Line: " << lineAt(offset) << " Column: " << columnAt(offset);
+  text << " Context: \"" << lex->tokenString << "\"" << endl << endl;
 
-  exit(1);
+  lex->notice(text.str(), true);
+}
+
+/* Builds tokens for the calling thread from state instead of
+ * the state for the input file.
+ */
+void setLexState(lexState *state)
+{
+  lex = state;
+}
+
+/* Sets where warnings and errors go. The function must not
+ * return when fatal is true.
+ */
+void setNotice(void (*show)(string, bool))
+{
+  lex->notice = show;
+}
+
+/* Prints a warning or error, exiting after an error.
+ */
+void printNotice(string text, bool fatal)
+{
+  cout << text;
+  if(fatal)
+  {
+    cout.flush();
+    exit(1);
+  }
 }
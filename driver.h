@@ -10,6 +10,17 @@
 #define DRIVER_H
 
 #include "token.h"
+#include <string>
+
+// Everything the driver keeps while building tokens from one input.
+// Each thread lexing part of a file has its own, see chunks.cpp.
+struct lexState
+{
+  std::string tokenString;	// Stores string to place into token
+  bool comment;			// Input starts inside a comment
+  bool partial;			// Input is part of a file, so a comment may go on past it
+  void (*notice)(std::string, bool);	// Shows warnings and errors, exiting after an error
+};
 
 token getToken();
 token buildToken(int);
@@ -18,7 +29,10 @@ void checkOperator(token &);
 
 int filterInput();
 
-void handleError(int, char);
-void errorExit(int, char);
+void handleError(int, char, int);
+void errorExit(int, char, int);
+void setLexState(lexState *);
+void setNotice(void (*)(std::string, bool));
+void printNotice(std::string, bool);
 
 #endif
@@ -42,14 +42,16 @@ static const int OP_TK = 102;
 static int fsa[ASCII_MAX][MAX_STATE] = {};
 static bool uninitialized = true;
 
-// Track current type of token
-static int state = 0;
+// Track current type of token, for each thread building tokens
+static __thread int state = 0;
 
 /* Initialize values in FSA using above static constants
  * Static constant names represent each state
  */
 void initFSA()
 {
+  uninitialized = false;
+
   //Set alphabet error values first to partially overwrite in later steps
   for(int i = 0; i < ASCII_MAX; i++)
   {
@@ -198,7 +200,6 @@ int setState(int c)
 {
   if(uninitialized)
   {
-    uninitialized = false;
     initFSA();
   }
   state = fsa[c][state];
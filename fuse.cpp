@@ -0,0 +1,408 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Execution engine for vmsim -f that runs common instruction
+ * sequences from codeGen.cpp as single superinstructions, so the
+ * loop dispatches once where the plain loop in virtMach.cpp would
+ * dispatch two or three times. Sequences like
+ * 	LOAD a / ADD b / STORE c
+ * 	LOAD a / SUB b / BRZNEG L
+ * 	STORE T / LOAD a
+ * are found once at load time by matchFusion.
+ *
+ * A branch can only arrive at the start of a superinstruction, so
+ * no sequence continues past an instruction that is a branch target.
+ * NOOPs are dropped entirely and branches to them go to the next
+ * instruction instead.
+ *
+ * Integers get data slots of their own holding their value, so every
+ * operand is read the same way. Branches keep a mask of accumulator
+ * signs they are taken for, which covers all five conditions with a
+ * single case.
+ */
+
+#include "fuse.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+using namespace std;
+
+// Names for printFusions, in the order of fuseOp.
+static const string fuseNames[] = {"READ", "WRITE", "LOAD", "STORE", "ADD", "SUB",
+  "MULT", "DIV", "BR", "BRxx", "STOP",
+  "LOAD+STORE", "LOAD+ADD", "LOAD+SUB", "LOAD+MULT",
+  "ADD+STORE", "SUB+STORE", "MULT+STORE",
+  "LOAD+ADD+STORE", "LOAD+SUB+STORE", "LOAD+MULT+STORE",
+  "STORE+LOAD", "LOAD+BRxx", "SUB+BRxx", "LOAD+SUB+BRxx"};
+static const int FUSE_NUM = 25;
+
+/* Builds the fused form of a loaded program.
+ */
+void fuseProgram(const program &prog, fusedProgram &fused)
+{
+  fused.code.clear();
+  fused.data = prog.data;
+
+  // Give every integer a slot, shared by equal values.
+  vector<int> slots(prog.code.size(), 0);
+  map<int, int> constants;
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    const instr &cur = prog.code[i];
+    if(cur.immediate)
+    {
+      map<int, int>::iterator it = constants.find(cur.arg);
+      if(it == constants.end())
+      {
+        it = constants.insert(pair<int, int>(cur.arg, fused.data.size())).first;
+        fused.data.push_back(cur.arg);
+      }
+      slots[i] = it->second;
+    }
+    else if(cur.op < BR_op)
+    {
+      slots[i] = cur.arg;
+    }
+  }
+
+  // Everything but NOOPs, and for every instruction the first of
+  // those at or after it, which is where a branch to it really goes.
+  vector<int> real;
+  vector<int> next(prog.code.size() + 1);
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    next[i] = real.size();
+    if(prog.code[i].op != NOOP_op)
+    {
+      real.push_back(i);
+    }
+  }
+  next[prog.code.size()] = real.size();
+  vector<bool> heads(real.size() + 1, false);
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    if(prog.code[i].op >= BR_op && prog.code[i].op <= BRZERO_op)
+    {
+      heads[next[prog.code[i].arg]] = true;
+    }
+  }
+
+  vector<int> fusedAt(real.size() + 1, 0);
+  unsigned int pos = 0;
+  while(pos < real.size())
+  {
+    fusedAt[pos] = fused.code.size();
+    fusedInstr cur;
+    pos += matchFusion(prog, real, heads, pos, cur, slots);
+    fused.code.push_back(cur);
+  }
+  fusedAt[real.size()] = fused.code.size();
+
+  // Every target is a head, so it starts a superinstruction.
+  for(unsigned int i = 0; i < fused.code.size(); i++)
+  {
+    fusedInstr &cur = fused.code[i];
+    if(cur.op == JUMP_fuse || cur.mask != 0)
+    {
+      cur.target = fusedAt[next[cur.target]];
+    }
+  }
+}
+
+/* Forms the superinstruction starting at real[pos], trying the
+ * longest sequences first. Returns how many instructions it covers.
+ * Branch targets are left as instruction indexes for fuseProgram.
+ */
+int matchFusion(const program &prog, const vector<int> &real, const vector<bool> &heads,
+                unsigned int pos, fusedInstr &cur, vector<int> &slots)
+{
+  // Up to three instructions that run one after the other.
+  opCode ops[3] = {NOOP_op, NOOP_op, NOOP_op};
+  int args[3] = {0, 0, 0};
+  int targets[3] = {0, 0, 0};
+  for(unsigned int k = 0; k < 3 && pos + k < real.size() && (k == 0 || !heads[pos + k]); k++)
+  {
+    const instr &ins = prog.code[real[pos + k]];
+    ops[k] = ins.op;
+    args[k] = slots[real[pos + k]];
+    targets[k] = ins.arg;
+  }
+
+  cur.a = args[0];
+  cur.b = args[1];
+  cur.c = args[2];
+  cur.mask = 0;
+  cur.target = targets[0];
+
+  if(ops[0] == LOAD_op && isArith(ops[1]) && ops[2] == STORE_op)
+  {
+    cur.op = static_cast<fuseOp>(LOADADDSTORE_fuse + ops[1] - ADD_op);
+    return 3;
+  }
+  if(ops[0] == LOAD_op && ops[1] == SUB_op && branchMask(ops[2]) != 0)
+  {
+    cur.op = LOADSUBBRANCH_fuse;
+    cur.mask = branchMask(ops[2]);
+    cur.target = targets[2];
+    return 3;
+  }
+  if(ops[0] == LOAD_op && isArith(ops[1]))
+  {
+    cur.op = static_cast<fuseOp>(LOADADD_fuse + ops[1] - ADD_op);
+    return 2;
+  }
+  if(isArith(ops[0]) && ops[1] == STORE_op)
+  {
+    cur.op = static_cast<fuseOp>(ADDSTORE_fuse + ops[0] - ADD_op);
+    return 2;
+  }
+  if(ops[0] == SUB_op && branchMask(ops[1]) != 0)
+  {
+    cur.op = SUBBRANCH_fuse;
+    cur.mask = branchMask(ops[1]);
+    cur.target = targets[1];
+    return 2;
+  }
+  if(ops[0] == LOAD_op && branchMask(ops[1]) != 0)
+  {
+    cur.op = LOADBRANCH_fuse;
+    cur.mask = branchMask(ops[1]);
+    cur.target = targets[1];
+    return 2;
+  }
+  if(ops[0] == LOAD_op && ops[1] == STORE_op)
+  {
+    cur.op = COPY_fuse;
+    return 2;
+  }
+  if(ops[0] == STORE_op && ops[1] == LOAD_op)
+  {
+    cur.op = STORELOAD_fuse;
+    return 2;
+  }
+
+  // Nothing to fuse with. Single instructions keep their order.
+  if(ops[0] <= DIV_op)
+  {
+    cur.op = static_cast<fuseOp>(ops[0]);
+  }
+  else if(ops[0] == BR_op)
+  {
+    cur.op = JUMP_fuse;
+  }
+  else if(ops[0] == STOP_op)
+  {
+    cur.op = STOP_fuse;
+  }
+  else
+  {
+    cur.op = BRANCH_fuse;
+    cur.mask = branchMask(ops[0]);
+  }
+  return 1;
+}
+
+/* Executes a fused program like execProgram in virtMach.cpp.
+ * counts is set to the times each superinstruction was dispatched.
+ */
+runResult runFused(const fusedProgram &fused, istream *in, ostream &out, vector<long> &counts)
+{
+  vector<int> data = fused.data;
+  int acc = 0;
+  unsigned int pc = 0;
+  counts.assign(fused.code.size(), 0);
+
+  while(pc < fused.code.size())
+  {
+    const fusedInstr &cur = fused.code[pc];
+    counts[pc]++;
+    pc++;
+
+    // The sign of acc picks a bit of the mask: negative, zero, positive.
+    switch(cur.op)
+    {
+    case READ_fuse:
+      if(!in || !(*in >> data[cur.a]))
+      {
+        return INPUT_run;
+      }
+      break;
+    case WRITE_fuse:
+      out << data[cur.a] << endl;
+      break;
+    case LOAD_fuse:
+      acc = data[cur.a];
+      break;
+    case STORE_fuse:
+      data[cur.a] = acc;
+      break;
+    case ADD_fuse:
+      acc += data[cur.a];
+      break;
+    case SUB_fuse:
+      acc -= data[cur.a];
+      break;
+    case MULT_fuse:
+      acc *= data[cur.a];
+      break;
+    case DIV_fuse:
+      if(data[cur.a] == 0)
+      {
+        return DIVIDE_run;
+      }
+      acc /= data[cur.a];
+      break;
+    case JUMP_fuse:
+      pc = cur.target;
+      break;
+    case BRANCH_fuse:
+      pc = (cur.mask >> ((acc >= 0) + (acc > 0))) & 1 ? cur.target : pc;
+      break;
+    case STOP_fuse:
+      return STOP_run;
+    case COPY_fuse:
+      acc = data[cur.a];
+      data[cur.b] = acc;
+      break;
+    case LOADADD_fuse:
+      acc = data[cur.a] + data[cur.b];
+      break;
+    case LOADSUB_fuse:
+      acc = data[cur.a] - data[cur.b];
+      break;
+    case LOADMULT_fuse:
+      acc = data[cur.a] * data[cur.b];
+      break;
+    case ADDSTORE_fuse:
+      acc += data[cur.a];
+      data[cur.b] = acc;
+      break;
+    case SUBSTORE_fuse:
+      acc -= data[cur.a];
+      data[cur.b] = acc;
+      break;
+    case MULTSTORE_fuse:
+      acc *= data[cur.a];
+      data[cur.b] = acc;
+      break;
+    case LOADADDSTORE_fuse:
+      acc = data[cur.a] + data[cur.b];
+      data[cur.c] = acc;
+      break;
+    case LOADSUBSTORE_fuse:
+      acc = data[cur.a] - data[cur.b];
+      data[cur.c] = acc;
+      break;
+    case LOADMULTSTORE_fuse:
+      acc = data[cur.a] * data[cur.b];
+      data[cur.c] = acc;
+      break;
+    case STORELOAD_fuse:
+      data[cur.a] = acc;
+      acc = data[cur.b];
+      break;
+    case LOADBRANCH_fuse:
+      acc = data[cur.a];
+      pc = (cur.mask >> ((acc >= 0) + (acc > 0))) & 1 ? cur.target : pc;
+      break;
+    case SUBBRANCH_fuse:
+      acc -= data[cur.a];
+      pc = (cur.mask >> ((acc >= 0) + (acc > 0))) & 1 ? cur.target : pc;
+      break;
+    case LOADSUBBRANCH_fuse:
+      acc = data[cur.a] - data[cur.b];
+      pc = (cur.mask >> ((acc >= 0) + (acc > 0))) & 1 ? cur.target : pc;
+      break;
+    }
+  }
+
+  return STOP_run;
+}
+
+/* Prints which superinstructions were formed and how often each
+ * was dispatched, with the totals compared to the plain loop.
+ */
+void printFusions(ostream &out, const fusedProgram &fused, const vector<long> &counts)
+{
+  vector<long> formed(FUSE_NUM, 0);
+  vector<long> fired(FUSE_NUM, 0);
+  long dispatches = 0;
+  long executed = 0;
+  for(unsigned int i = 0; i < fused.code.size(); i++)
+  {
+    fuseOp op = fused.code[i].op;
+    formed[op]++;
+    fired[op] += counts[i];
+    dispatches += counts[i];
+    executed += counts[i] * fuseLength(op);
+  }
+
+  out << dispatches << " dispatches for " << executed
+      << " instructions, not counting NOOP\n";
+  out << left << setw(18) << "superinstruction" << right << setw(8) << "formed"
+      << setw(14) << "dispatched" << endl;
+  for(int i = COPY_fuse; i < FUSE_NUM; i++)
+  {
+    if(formed[i] > 0)
+    {
+      out << left << setw(18) << fuseName(static_cast<fuseOp>(i)) << right
+          << setw(8) << formed[i] << setw(14) << fired[i] << endl;
+    }
+  }
+}
+
+/* Number of instructions a superinstruction stands for.
+ */
+int fuseLength(fuseOp op)
+{
+  if(op >= LOADADDSTORE_fuse && op <= LOADMULTSTORE_fuse)
+  {
+    return 3;
+  }
+  if(op == LOADSUBBRANCH_fuse)
+  {
+    return 3;
+  }
+  return op >= COPY_fuse ? 2 : 1;
+}
+
+/* Gives the instructions a superinstruction stands for.
+ */
+string fuseName(fuseOp op)
+{
+  return fuseNames[op];
+}
+
+/* Bits for the accumulator signs a conditional branch is taken
+ * for: 1 for negative, 2 for zero, 4 for positive. 0 for anything
+ * that is not a conditional branch.
+ */
+int branchMask(opCode op)
+{
+  switch(op)
+  {
+  case BRNEG_op:
+    return 1;
+  case BRZNEG_op:
+    return 3;
+  case BRPOS_op:
+    return 4;
+  case BRZPOS_op:
+    return 6;
+  case BRZERO_op:
+    return 2;
+  default:
+    return 0;
+  }
+}
+
+/* True for arithmetic that fuses. DIV is left alone since it
+ * needs its own check for zero.
+ */
+bool isArith(opCode op)
+{
+  return op == ADD_op || op == SUB_op || op == MULT_op;
+}
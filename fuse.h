@@ -0,0 +1,52 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for fuse.cpp.
+ */
+
+#ifndef FUSE_H
+#define FUSE_H
+
+#include "virtMach.h"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Single instructions first, then the fused sequences they form,
+// named after the instructions they replace.
+typedef enum {READ_fuse, WRITE_fuse, LOAD_fuse, STORE_fuse, ADD_fuse, SUB_fuse,
+              MULT_fuse, DIV_fuse, JUMP_fuse, BRANCH_fuse, STOP_fuse,
+              COPY_fuse, LOADADD_fuse, LOADSUB_fuse, LOADMULT_fuse,
+              ADDSTORE_fuse, SUBSTORE_fuse, MULTSTORE_fuse,
+              LOADADDSTORE_fuse, LOADSUBSTORE_fuse, LOADMULTSTORE_fuse,
+              STORELOAD_fuse, LOADBRANCH_fuse, SUBBRANCH_fuse,
+              LOADSUBBRANCH_fuse} fuseOp;
+
+struct fusedInstr
+{
+  fuseOp op;
+  int a, b, c;		// Data slots in the order the instructions use them
+  int mask;		// Signs of the accumulator a branch is taken for
+  int target;		// Fused index a branch goes to
+};
+
+struct fusedProgram
+{
+  std::vector<fusedInstr> code;
+  std::vector<int> data;	// Variables, then a slot for every integer used
+};
+
+void fuseProgram(const program &, fusedProgram &);
+int matchFusion(const program &, const std::vector<int> &, const std::vector<bool> &,
+                unsigned int, fusedInstr &, std::vector<int> &);
+runResult runFused(const fusedProgram &, std::istream *, std::ostream &, std::vector<long> &);
+void printFusions(std::ostream &, const fusedProgram &, const std::vector<long> &);
+
+int fuseLength(fuseOp);
+std::string fuseName(fuseOp);
+int branchMask(opCode);
+bool isArith(opCode);
+
+#endif
@@ -0,0 +1,105 @@
+# Author: John Soderstrom
+# Due Date: 5/14/2020
+#
+# Grammar for the table-driven parser, see llParser.cpp. llgen turns
+# it into the tables in llTables.h when comp is built.
+#
+# 	token NAME "text"	How a token is named when it was expected
+# 	A -> x y z		An alternative for A, nothing after -> for empty
+# 	A else -> x y z		An alternative also taken on any token that
+# 				starts no other alternative of A
+# 	A else error "label" "expected"
+# 				The error printed on any such token instead
+#
+# Names ending in _tk are tokens from token.h, and a ! after one keeps
+# it in the node, token1 first. Every other name is a nonterminal and
+# builds a node with that label, children filled in order and empty
+# alternatives left out. Names starting with _ build no node, their
+# children and tokens go to the node they are in. The first rule is
+# where parsing starts.
+#
+# The tree and every error are the same as parser.cpp builds and
+# prints, but for expressions, which parser.cpp builds with only
+# operators and operands. The ; ending a statement is part of the statement, so a
+# missing one names the statement the way stat() does.
+
+token IDENT_tk "IDENTIFIER"
+token NUM_tk "INTEGER"
+token CEQUAL_tk ":="
+token SCOLON_tk ";"
+token OBRACE_tk "{"
+token CBRACE_tk "}"
+token OBRACKET_tk "["
+token CBRACKET_tk "]"
+token CPAREN_tk ")"
+token THEN_tk "then"
+
+program else -> vars block
+
+vars -> DECLARE_tk IDENT_tk! CEQUAL_tk NUM_tk! SCOLON_tk vars
+vars else ->
+
+block -> OBRACE_tk vars stats CBRACE_tk
+block else error "block" "{"
+
+stats else -> stat mStat
+
+mStat -> stat mStat
+mStat ->
+mStat else error "block" "}"
+
+stat -> in
+stat -> out
+stat -> block
+stat -> iffy
+stat -> loop
+stat -> assign
+stat -> label
+stat -> goto
+stat else error "stat" "BLOCK, IDENTIFIER, or KEYWORD.\n  Keywords: in, out, iffy, loop, goto, label"
+
+in -> IN_tk IDENT_tk! SCOLON_tk
+out -> OUT_tk expr SCOLON_tk
+iffy -> IFFY_tk OBRACKET_tk expr RO expr CBRACKET_tk THEN_tk stat SCOLON_tk
+loop -> LOOP_tk OBRACKET_tk expr RO expr CBRACKET_tk stat SCOLON_tk
+assign -> IDENT_tk! CEQUAL_tk expr SCOLON_tk
+label -> LABEL_tk IDENT_tk! SCOLON_tk
+goto -> GOTO_tk IDENT_tk! SCOLON_tk
+
+# <, <<, <>, >, >>, ==
+RO -> LESS_tk! _less
+RO -> GREATER_tk! _greater
+RO -> DEQUAL_tk!
+RO else error "RO" "<, <<, >, >>, <>, or =="
+_less -> LESS_tk!
+_less -> GREATER_tk!
+_less else ->
+_greater -> GREATER_tk!
+_greater else ->
+
+# <expr> -> <N> - <expr> | <N>
+expr -> N _minus
+expr else error "expr" "*, (, IDENTIFIER, or INTEGER"
+_minus -> MINUS_tk! expr
+_minus else ->
+
+# <N> -> <A> / <N> | <A> * <N> | <A>
+N else -> A _times
+_times -> DIVIDE_tk! N
+_times -> TIMES_tk! N
+_times else ->
+
+# <A> -> <M> + <A> | <M>
+A else -> M _plus
+_plus -> PLUS_tk! A
+_plus else ->
+
+# <M> -> * <M> | <R>
+M -> TIMES_tk! M
+M else -> R
+
+# <R> -> ( <expr> ) | IDENTIFIER | INTEGER
+R -> OPAREN_tk expr CPAREN_tk
+R -> IDENT_tk!
+R -> NUM_tk!
+R else error "R" "IDENTIFIER, INTEGER, or ("
@@ -0,0 +1,262 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Translates a loaded VirtMach program into x86-64 machine code
+ * and runs it, as an alternative to the loop in virtMach.cpp.
+ *
+ * The accumulator lives in eax and every variable is a 32 bit slot
+ * in an array addressed through rbx, so most instructions become a
+ * single machine instruction on [rbx + 4 * index]. r12 holds the
+ * jitRuntime for the READ and WRITE helpers, which are called with
+ * the accumulator saved in r13d. Branches test eax against zero.
+ * Arithmetic wraps around in 32 bits like the interpreter.
+ *
+ * Code is written into a buffer from mmap, which is only made
+ * executable once it is complete. Hosts that are not x86-64 with
+ * the System V calling convention are refused, and the interpreter
+ * has to be used there.
+ */
+
+#include "jit.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+using namespace std;
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define JIT_HOST
+#include <sys/mman.h>
+#endif
+
+// Compiled code takes the variable slots and the runtime, and
+// returns how the run ended.
+typedef int (*jitFunc)(int *, jitRuntime *);
+
+// Branch targets below 0 are the exits, one per runResult.
+static const int EXIT_TARGET = -1;
+
+/* True if programs can be compiled and run on this host.
+ */
+bool jitSupported()
+{
+#ifdef JIT_HOST
+  return true;
+#else
+  return false;
+#endif
+}
+
+/* Compiles a program and runs it with the given input and output.
+ * A null in means no input is available. Sets result to how the
+ * run ended. Returns false without running anything if this host
+ * is not supported or executable memory is not available.
+ */
+bool jitProgram(const program &prog, istream *in, ostream &out, runResult &result)
+{
+#ifndef JIT_HOST
+  return false;
+#else
+  vector<unsigned char> code;
+  vector<int> starts;
+  vector<int> fixes;	// Position of every 32 bit branch offset
+  vector<int> targets;	// Instruction each one goes to
+
+  // push rbx, r12, r13, which also aligns the stack for calls
+  putBytes(code, "\x53\x41\x54\x41\x55", 5);
+  // mov rbx, rdi; mov r12, rsi; xor eax, eax
+  putBytes(code, "\x48\x89\xfb\x49\x89\xf4\x31\xc0", 8);
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    starts.push_back(code.size());
+    jitInstr(prog.code[i], code, fixes, targets);
+  }
+
+  // One exit per result: mov eax, result; pop r13, r12, rbx; ret
+  vector<int> exits;
+  for(int i = STOP_run; i <= DIVIDE_run; i++)
+  {
+    exits.push_back(code.size());
+    putByte(code, 0xb8);
+    putInt(code, i);
+    putBytes(code, "\x41\x5d\x41\x5c\x5b\xc3", 6);
+  }
+  for(unsigned int i = 0; i < fixes.size(); i++)
+  {
+    int target = targets[i] >= 0 ? starts[targets[i]] : exits[EXIT_TARGET - targets[i]];
+    int offset = target - (fixes[i] + 4);
+    memcpy(&code[fixes[i]], &offset, 4);
+  }
+
+  void *buffer = mmap(NULL, code.size(), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(buffer == MAP_FAILED)
+  {
+    return false;
+  }
+  memcpy(buffer, &code[0], code.size());
+  if(mprotect(buffer, code.size(), PROT_READ | PROT_EXEC) != 0)
+  {
+    munmap(buffer, code.size());
+    return false;
+  }
+
+  vector<int> data = prog.data;	// Keep the loaded program reusable
+  data.push_back(0);		// Never empty, so there is a first slot
+  jitRuntime runtime;
+  runtime.in = in;
+  runtime.out = &out;
+  jitFunc run = reinterpret_cast<jitFunc>(buffer);
+  result = static_cast<runResult>(run(&data[0], &runtime));
+
+  munmap(buffer, code.size());
+  return true;
+#endif
+}
+
+/* Appends the machine code for one instruction. Branches and
+ * the checks that can end a run leave a 32 bit offset to fill in
+ * later, recorded in fixes with where it goes in targets.
+ */
+void jitInstr(const instr &cur, vector<unsigned char> &code, vector<int> &fixes,
+              vector<int> &targets)
+{
+  int slot = cur.arg * 4;
+  switch(cur.op)
+  {
+  case READ_op:
+    // mov r13d, eax; lea rsi, [rbx + slot]; mov rdi, r12
+    putBytes(code, "\x41\x89\xc5\x48\x8d\xb3", 6);
+    putInt(code, slot);
+    putBytes(code, "\x4c\x89\xe7\x48\xb8", 5);
+    putLong(code, (unsigned long)&jitRead);
+    // call rax; test eax, eax; jz input exit
+    putBytes(code, "\xff\xd0\x85\xc0\x0f\x84", 6);
+    fixes.push_back(code.size());
+    targets.push_back(EXIT_TARGET - INPUT_run);
+    putInt(code, 0);
+    // mov eax, r13d
+    putBytes(code, "\x44\x89\xe8", 3);
+    break;
+  case WRITE_op:
+    // mov r13d, eax; mov edi, value
+    putBytes(code, "\x41\x89\xc5", 3);
+    putBytes(code, cur.immediate ? "\xbf" : "\x8b\xbb", cur.immediate ? 1 : 2);
+    putInt(code, cur.immediate ? cur.arg : slot);
+    // mov rsi, r12; mov rax, jitWrite; call rax; mov eax, r13d
+    putBytes(code, "\x4c\x89\xe6\x48\xb8", 5);
+    putLong(code, (unsigned long)&jitWrite);
+    putBytes(code, "\xff\xd0\x44\x89\xe8", 5);
+    break;
+  case LOAD_op:
+    putBytes(code, cur.immediate ? "\xb8" : "\x8b\x83", cur.immediate ? 1 : 2);
+    putInt(code, cur.immediate ? cur.arg : slot);
+    break;
+  case STORE_op:
+    putBytes(code, "\x89\x83", 2);
+    putInt(code, slot);
+    break;
+  case ADD_op:
+    putBytes(code, cur.immediate ? "\x05" : "\x03\x83", cur.immediate ? 1 : 2);
+    putInt(code, cur.immediate ? cur.arg : slot);
+    break;
+  case SUB_op:
+    putBytes(code, cur.immediate ? "\x2d" : "\x2b\x83", cur.immediate ? 1 : 2);
+    putInt(code, cur.immediate ? cur.arg : slot);
+    break;
+  case MULT_op:
+    putBytes(code, cur.immediate ? "\x69\xc0" : "\x0f\xaf\x83", cur.immediate ? 2 : 3);
+    putInt(code, cur.immediate ? cur.arg : slot);
+    break;
+  case DIV_op:
+    // mov ecx, divisor; test ecx, ecx; jz divide exit
+    putBytes(code, cur.immediate ? "\xb9" : "\x8b\x8b", cur.immediate ? 1 : 2);
+    putInt(code, cur.immediate ? cur.arg : slot);
+    putBytes(code, "\x85\xc9\x0f\x84", 4);
+    fixes.push_back(code.size());
+    targets.push_back(EXIT_TARGET - DIVIDE_run);
+    putInt(code, 0);
+    // idiv faults on the most negative value over -1, so dividing
+    // by -1 negates instead, wrapping around like the interpreter.
+    // cmp ecx, -1; jne idiv; neg eax; jmp past; cdq; idiv ecx
+    putBytes(code, "\x83\xf9\xff\x75\x04\xf7\xd8\xeb\x03\x99\xf7\xf9", 12);
+    break;
+  case BR_op:
+    putByte(code, 0xe9);
+    fixes.push_back(code.size());
+    targets.push_back(cur.arg);
+    putInt(code, 0);
+    break;
+  case BRNEG_op:
+  case BRZNEG_op:
+  case BRPOS_op:
+  case BRZPOS_op:
+  case BRZERO_op:
+    // test eax, eax; then js, jle, jg, jns, or je
+    putBytes(code, "\x85\xc0\x0f", 3);
+    putByte(code, cur.op == BRNEG_op ? 0x88 : cur.op == BRZNEG_op ? 0x8e
+                  : cur.op == BRPOS_op ? 0x8f : cur.op == BRZPOS_op ? 0x89 : 0x84);
+    fixes.push_back(code.size());
+    targets.push_back(cur.arg);
+    putInt(code, 0);
+    break;
+  case NOOP_op:
+    break;
+  case STOP_op:
+    putByte(code, 0xe9);
+    fixes.push_back(code.size());
+    targets.push_back(EXIT_TARGET - STOP_run);
+    putInt(code, 0);
+    break;
+  }
+}
+
+/* Appends a single byte.
+ */
+void putByte(vector<unsigned char> &code, int byte)
+{
+  code.push_back(byte & 0xff);
+}
+
+/* Appends count bytes of a fixed encoding.
+ */
+void putBytes(vector<unsigned char> &code, const char *bytes, int count)
+{
+  code.insert(code.end(), bytes, bytes + count);
+}
+
+/* Appends a 32 bit little endian value.
+ */
+void putInt(vector<unsigned char> &code, int value)
+{
+  unsigned int bits = value;
+  for(int i = 0; i < 4; i++)
+  {
+    putByte(code, bits >> (8 * i));
+  }
+}
+
+/* Appends a 64 bit little endian value, used for helper addresses.
+ */
+void putLong(vector<unsigned char> &code, unsigned long value)
+{
+  for(int i = 0; i < 8; i++)
+  {
+    putByte(code, value >> (8 * i));
+  }
+}
+
+/* Called by compiled READ. Returns 0 if no value could be read.
+ */
+int jitRead(jitRuntime *runtime, int *slot)
+{
+  return runtime->in && (*runtime->in >> *slot) ? 1 : 0;
+}
+
+/* Called by compiled WRITE.
+ */
+void jitWrite(int value, jitRuntime *runtime)
+{
+  *runtime->out << value << endl;
+}
@@ -0,0 +1,36 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for jit.cpp.
+ */
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "virtMach.h"
+#include <istream>
+#include <ostream>
+#include <vector>
+
+// Passed to compiled code and handed back to the READ and WRITE
+// helpers, which do the actual input and output.
+struct jitRuntime
+{
+  std::istream *in;
+  std::ostream *out;
+};
+
+bool jitSupported();
+bool jitProgram(const program &, std::istream *, std::ostream &, runResult &);
+void jitInstr(const instr &, std::vector<unsigned char> &, std::vector<int> &,
+              std::vector<int> &);
+
+void putByte(std::vector<unsigned char> &, int);
+void putBytes(std::vector<unsigned char> &, const char *, int);
+void putInt(std::vector<unsigned char> &, int);
+void putLong(std::vector<unsigned char> &, unsigned long);
+int jitRead(jitRuntime *, int *);
+void jitWrite(int, jitRuntime *);
+
+#endif
@@ -0,0 +1,66 @@
+LOAD 0
+STORE T2
+LOAD 1
+SUB T2
+STORE T0
+WRITE T0
+LOAD 1
+STORE T2
+LOAD 2
+MULT T2
+STORE T0
+WRITE T0
+LOAD 2
+STORE T2
+LOAD 7
+DIV T2
+STORE T0
+WRITE T0
+LOAD 3
+STORE T2
+LOAD 1
+ADD T2
+STORE T0
+WRITE T0
+LOAD 9
+STORE T2
+LOAD 4
+MULT -1
+ADD T2
+STORE T0
+WRITE T0
+LOAD 6
+STORE T0
+WRITE T0
+LOAD 12
+STORE T2
+LOAD 19
+SUB T2
+STORE T0
+WRITE T0
+LOAD 4
+STORE T2
+LOAD 4
+MULT -1
+MULT -1
+ADD T2
+STORE T0
+WRITE T0
+LOAD 9
+STORE T2
+LOAD 81
+DIV T2
+STORE T0
+WRITE T0
+LOAD 5
+STORE T2
+LOAD 2
+MULT T2
+STORE T0
+WRITE T0
+LOAD 11
+STORE T0
+WRITE T0
+STOP
+T0 0
+T2 0
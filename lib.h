@@ -10,7 +10,9 @@
 
 #include "token.h"
 #include <stdio.h>
+#include <string>
 
 FILE *handleArgs(int, char**, std::string &);
+void handleOption(std::string);
 
 #endif
@@ -0,0 +1,138 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Parses with tables in place of recursive descent, for
+ * comp --ll-parser. The grammar is written out in grammar.ll, and
+ * llgen builds llTables.h from it when comp is built.
+ *
+ * An explicit stack of grammar symbols stands in for the calls of
+ * parser.cpp. The nonterminal on top picks its alternative from the
+ * table by the next token alone, and its symbols replace it on the
+ * stack, first symbol on top. A token on top must match the next
+ * token. Nested programs only grow the vectors, never the call stack.
+ *
+ * A second stack holds the nodes being built. A nonterminal with
+ * a label pushes its node along with an end marker below its
+ * symbols, so the node is popped once they are all matched. Children
+ * and kept tokens go to the node on top, in order. Errors print the
+ * same as parser.cpp, naming the node on top for a missing token.
+ *
+ * Expressions are built in full, a node for every <expr>, <N>, <A>,
+ * <M> and <R> an operand passes through, where parser.cpp only builds
+ * operators and operands. simplify.cpp skips the nodes that pass
+ * their child along, so code generation sees the same tree.
+ */
+
+#include "llParser.h"
+#include "parser.h"
+#include "scanner.h"
+#include "node.h"
+#include "token.h"
+#include <vector>
+using namespace std;
+
+#include "llTables.h"
+
+static bool tableParser = false;	// Parse with the tables
+static const int LL_END = -1;	// Ends the symbols of a node on the stack
+
+/* Turns on parsing with the tables.
+ */
+void setTableParser(bool on)
+{
+  tableParser = on;
+}
+
+/* True if the tables are used in place of parser().
+ */
+bool getTableParser()
+{
+  return tableParser;
+}
+
+/* Builds the parse tree from every token of the input, the same
+ * tree parser() does but for the nodes of expressions.
+ */
+Node* llParser()
+{
+  token tk = scanToken();
+  Node* root = NULL;
+  vector<int> symbols;
+  vector<Node*> nodes;
+  symbols.push_back(LL_NT);
+
+  while(!symbols.empty())
+  {
+    int symbol = symbols.back();
+    symbols.pop_back();
+
+    if(symbol == LL_END)
+    {
+      nodes.pop_back();
+    }
+    else if(symbol < LL_NT || symbol >= LL_KEEP)
+    {
+      // A token, matched and kept in the node on top if asked
+      bool keep = symbol >= LL_KEEP;
+      int id = keep ? symbol - LL_KEEP : symbol;
+      if(tk.id != id)
+      {
+        errorAt(tk, nodes.back()->label, llShown[id]);
+      }
+      if(keep)
+      {
+        Node* node = nodes.back();
+        if(node->token1.tokenString.empty())
+        {
+          node->token1 = tk;
+        }
+        else
+        {
+          node->token2 = tk;
+        }
+      }
+      tk = scanToken();
+    }
+    else
+    {
+      int nt = symbol - LL_NT;
+      int alternative = llTable[nt][tk.id];
+      if(alternative < 0)
+      {
+        errorAt(tk, llErrorLabels[nt], llErrorExpected[nt]);
+      }
+      int first = llStarts[alternative];
+      int last = llStarts[alternative + 1];
+
+      // Empty alternatives build no node, as parser() returns NULL
+      if(llLabels[nt] && first < last)
+      {
+        Node* node = getNode(llLabels[nt]);
+        if(nodes.empty())
+        {
+          root = node;
+        }
+        else
+        {
+          Node* parent = nodes.back();
+          Node** slot = !parent->child1 ? &parent->child1 : !parent->child2 ? &parent->child2
+                        : !parent->child3 ? &parent->child3 : &parent->child4;
+          *slot = node;
+        }
+        nodes.push_back(node);
+        symbols.push_back(LL_END);
+      }
+      for(int i = last - 1; i >= first; i--)
+      {
+        symbols.push_back(llSymbols[i]);
+      }
+    }
+  }
+
+  if(tk.id != EOF_tk)
+  {
+    errorAt(tk, root->label, "End of File");
+  }
+  return root;
+}
@@ -0,0 +1,17 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for llParser.cpp.
+ */
+
+#ifndef LLPARSER_H
+#define LLPARSER_H
+
+#include "node.h"
+
+void setTableParser(bool);
+bool getTableParser();
+Node* llParser();
+
+#endif
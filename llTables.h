@@ -0,0 +1,63 @@
+/****************************
+ * Generated by llgen from grammar.ll, do not edit.
+ *
+ * Tables for llParser.cpp.
+ */
+
+#ifndef LLTABLES_H
+#define LLTABLES_H
+
+#include "token.h"
+#include <stddef.h>
+
+static constexpr int LL_TOKENS = 35;
+static constexpr int LL_NONTERMINALS = 24;
+static constexpr int LL_RULES = 45;
+static constexpr int LL_NT = LL_TOKENS;	// First nonterminal, the start
+static constexpr int LL_KEEP = LL_NT + LL_NONTERMINALS;	// Added to a token kept
+
+// Label of the node each nonterminal builds, or NULL for none.
+static constexpr const char *llLabels[LL_NONTERMINALS] = {"program", "vars", "block", "stats", "mStat", "stat", "in", "out", "iffy", "loop", "assign", "label", "goto", "RO", NULL, NULL, "expr", NULL, "N", NULL, "A", NULL, "M", "R"};
+
+// Alternative to take for each nonterminal and token, -1 for an error.
+static constexpr short llTable[LL_NONTERMINALS][LL_TOKENS] = {
+  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},	// program
+  {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2},	// vars
+  {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},	// block
+  {4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4},	// stats
+  {5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 5, 6, -1, -1, -1, 5, 5, 5, -1, -1, -1, 5, 5, -1, 5, -1, -1, -1, -1},	// mStat
+  {12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, -1, -1, -1, -1, 13, 14, 11, -1, -1, -1, 7, 8, -1, 10, -1, -1, -1, -1},	// stat
+  {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 15, -1, -1, -1, -1, -1, -1, -1},	// in
+  {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 16, -1, -1, -1, -1, -1, -1},	// out
+  {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 17, -1, -1, -1, -1},	// iffy
+  {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 18, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},	// loop
+  {19, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},	// assign
+  {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 20, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},	// label
+  {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 21, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},	// goto
+  {-1, -1, -1, -1, 24, 22, 23, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},	// RO
+  {27, 27, 27, 27, 27, 25, 26, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27},	// _less
+  {29, 29, 29, 29, 29, 29, 28, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29},	// _greater
+  {30, 30, -1, -1, -1, -1, -1, -1, -1, 30, -1, -1, -1, 30, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},	// expr
+  {32, 32, 32, 32, 32, 32, 32, 32, 31, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32},	// _minus
+  {33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33},	// N
+  {36, 36, 36, 36, 36, 36, 36, 36, 36, 35, 34, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36},	// _times
+  {37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37},	// A
+  {39, 39, 39, 39, 39, 39, 39, 38, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39, 39},	// _plus
+  {41, 41, 41, 41, 41, 41, 41, 41, 41, 40, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41, 41},	// M
+  {43, 44, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 42, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}	// R
+};
+
+// Error printed when a nonterminal has no alternative for a token.
+static constexpr const char *llErrorLabels[LL_NONTERMINALS] = {"program", "vars", "block", "stats", "block", "stat", "in", "out", "iffy", "loop", "assign", "label", "goto", "RO", "_less", "_greater", "expr", "_minus", "N", "_times", "A", "_plus", "M", "R"};
+static constexpr const char *llErrorExpected[LL_NONTERMINALS] = {"DECLARE_tk, {", "DECLARE_tk", "{", "GOTO_tk, IDENTIFIER, IFFY_tk, IN_tk, LABEL_tk, LOOP_tk, {, OUT_tk", "}", "BLOCK, IDENTIFIER, or KEYWORD.\n  Keywords: in, out, iffy, loop, goto, label", "IN_tk", "OUT_tk", "IFFY_tk", "LOOP_tk", "IDENTIFIER", "LABEL_tk", "GOTO_tk", "<, <<, >, >>, <>, or ==", "GREATER_tk, LESS_tk", "GREATER_tk", "*, (, IDENTIFIER, or INTEGER", "MINUS_tk", "IDENTIFIER, INTEGER, OPAREN_tk, TIMES_tk", "DIVIDE_tk, TIMES_tk", "IDENTIFIER, INTEGER, OPAREN_tk, TIMES_tk", "PLUS_tk", "IDENTIFIER, INTEGER, OPAREN_tk, TIMES_tk", "IDENTIFIER, INTEGER, or ("};
+
+// How each token is named when it was expected.
+static constexpr const char *llShown[LL_TOKENS] = {"IDENTIFIER", "INTEGER", "COLON_tk", ":=", "DEQUAL_tk", "LESS_tk", "GREATER_tk", "PLUS_tk", "MINUS_tk", "TIMES_tk", "DIVIDE_tk", "PERCENT_tk", "DOT_tk", "OPAREN_tk", ")", "COMMA_tk", "{", "}", ";", "[", "]", "LABEL_tk", "GOTO_tk", "LOOP_tk", "VOID_tk", "DECLARE_tk", "RETURN_tk", "IN_tk", "OUT_tk", "PROGRAM_tk", "IFFY_tk", "then", "ASSIGN_tk", "DATA_tk", "EOF_tk"};
+
+// Symbols of every alternative, those of alternative r from
+// llStarts[r] up to llStarts[r + 1]. Tokens are their tokenID,
+// plus LL_KEEP if kept, and nonterminals are LL_NT plus their number.
+static constexpr short llStarts[LL_RULES + 1] = {0, 2, 8, 8, 12, 14, 16, 16, 17, 18, 19, 20, 21, 22, 23, 24, 27, 30, 39, 47, 51, 54, 57, 59, 61, 62, 63, 64, 64, 65, 65, 67, 69, 69, 71, 73, 75, 75, 77, 79, 79, 81, 82, 85, 86, 87};
+static constexpr short llSymbols[87] = {LL_NT + 1, LL_NT + 2, DECLARE_tk, LL_KEEP + IDENT_tk, CEQUAL_tk, LL_KEEP + NUM_tk, SCOLON_tk, LL_NT + 1, OBRACE_tk, LL_NT + 1, LL_NT + 3, CBRACE_tk, LL_NT + 5, LL_NT + 4, LL_NT + 5, LL_NT + 4, LL_NT + 6, LL_NT + 7, LL_NT + 2, LL_NT + 8, LL_NT + 9, LL_NT + 10, LL_NT + 11, LL_NT + 12, IN_tk, LL_KEEP + IDENT_tk, SCOLON_tk, OUT_tk, LL_NT + 16, SCOLON_tk, IFFY_tk, OBRACKET_tk, LL_NT + 16, LL_NT + 13, LL_NT + 16, CBRACKET_tk, THEN_tk, LL_NT + 5, SCOLON_tk, LOOP_tk, OBRACKET_tk, LL_NT + 16, LL_NT + 13, LL_NT + 16, CBRACKET_tk, LL_NT + 5, SCOLON_tk, LL_KEEP + IDENT_tk, CEQUAL_tk, LL_NT + 16, SCOLON_tk, LABEL_tk, LL_KEEP + IDENT_tk, SCOLON_tk, GOTO_tk, LL_KEEP + IDENT_tk, SCOLON_tk, LL_KEEP + LESS_tk, LL_NT + 14, LL_KEEP + GREATER_tk, LL_NT + 15, LL_KEEP + DEQUAL_tk, LL_KEEP + LESS_tk, LL_KEEP + GREATER_tk, LL_KEEP + GREATER_tk, LL_NT + 18, LL_NT + 17, LL_KEEP + MINUS_tk, LL_NT + 16, LL_NT + 20, LL_NT + 19, LL_KEEP + DIVIDE_tk, LL_NT + 18, LL_KEEP + TIMES_tk, LL_NT + 18, LL_NT + 22, LL_NT + 21, LL_KEEP + PLUS_tk, LL_NT + 20, LL_KEEP + TIMES_tk, LL_NT + 22, LL_NT + 23, OPAREN_tk, LL_NT + 16, CPAREN_tk, LL_KEEP + IDENT_tk, LL_KEEP + NUM_tk};
+
+#endif
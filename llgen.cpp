@@ -0,0 +1,523 @@
+/*******************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Usage:
+ * llgen grammar tokens output
+ *
+ * Builds the LL(1) tables for llParser.cpp from a grammar, see
+ * grammar.ll for how one is written. tokens is token.h, read for the
+ * order of tokenID so the table has a column for every token.
+ *
+ * FIRST and FOLLOW sets are found the usual way, by going over the
+ * rules until nothing changes. Each alternative goes in the table
+ * under every token in its FIRST set, and under FOLLOW of its
+ * nonterminal if it can be empty. Two alternatives under one token
+ * make the grammar not LL(1), and llgen stops with an error. Tokens
+ * left over take the else alternative or error of the nonterminal.
+ *
+ * The output is a header of constexpr arrays, so comp never builds
+ * a table while running.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <stdlib.h>
+using namespace std;
+
+struct rule
+{
+  int lhs;			// Nonterminal it is an alternative of
+  vector<string> symbols;	// Names as written, ! included
+};
+
+static vector<string> tokens;		// tokenID names in order
+static map<string, string> shown;	// How tokens are named in errors
+static vector<string> names;		// Nonterminals in order of first rule
+static map<string, int> numbers;	// Number of each nonterminal
+static vector<rule> rules;
+static vector<int> elseRule;		// Else alternative of each, -1 for none
+static vector<string> errorLabel;	// Else error of each, if any
+static vector<string> errorExpected;
+static vector<bool> nullable;
+static vector<set<string> > first;
+static vector<set<string> > follow;
+
+void readTokens(string);
+void readGrammar(string);
+vector<string> splitLine(string, int);
+int nonterminal(string);
+bool isToken(string);
+string bare(string);
+void findSets();
+bool firstOf(const vector<string> &, unsigned int, set<string> &);
+void writeTables(string);
+string escape(string);
+void fail(string);
+
+int main(int argc, char *argv[])
+{
+  if(argc != 4)
+  {
+    cout << "usage: llgen grammar tokens output\n";
+    exit(1);
+  }
+  readTokens(argv[2]);
+  readGrammar(argv[1]);
+  findSets();
+  writeTables(argv[3]);
+  return 0;
+}
+
+/* Reads the names of enum tokenID in order.
+ */
+void readTokens(string filename)
+{
+  ifstream in(filename.c_str());
+  stringstream text;
+  text << in.rdbuf();
+  string all = text.str();
+  size_t start = all.find("enum tokenID");
+  size_t open = all.find('{', start);
+  size_t close = all.find('}', open);
+  if(start == string::npos || open == string::npos || close == string::npos)
+  {
+    fail("No enum tokenID in " + filename);
+  }
+  string list = all.substr(open + 1, close - open - 1);
+  for(unsigned int i = 0; i < list.length(); i++)
+  {
+    if(list[i] == ',')
+    {
+      list[i] = ' ';
+    }
+  }
+  stringstream words(list);
+  string word;
+  while(words >> word)
+  {
+    tokens.push_back(word);
+    shown[word] = word;
+  }
+}
+
+/* Reads every token naming line and rule of the grammar.
+ */
+void readGrammar(string filename)
+{
+  ifstream in(filename.c_str());
+  if(!in.is_open())
+  {
+    fail("Unable to open " + filename);
+  }
+  string line;
+  int lineNum = 0;
+  while(getline(in, line))
+  {
+    lineNum++;
+    vector<string> words = splitLine(line, lineNum);
+    if(words.empty())
+    {
+      continue;
+    }
+    if(words[0].compare("token") == 0)
+    {
+      if(words.size() != 3 || !isToken(words[1]))
+      {
+        fail("Bad token line in " + filename);
+      }
+      shown[words[1]] = words[2];
+      continue;
+    }
+
+    int lhs = nonterminal(words[0]);
+    unsigned int at = 1;
+    bool isElse = words.size() > 1 && words[1].compare("else") == 0;
+    if(isElse)
+    {
+      at++;
+    }
+    if(isElse && words.size() == 5 && words[2].compare("error") == 0)
+    {
+      errorLabel[lhs] = words[3];
+      errorExpected[lhs] = words[4];
+      continue;
+    }
+    if(words.size() <= at || words[at].compare("->") != 0)
+    {
+      stringstream message;
+      message << "Expected -> on line " << lineNum << " of " << filename;
+      fail(message.str());
+    }
+    rule added;
+    added.lhs = lhs;
+    added.symbols.assign(words.begin() + at + 1, words.end());
+    rules.push_back(added);
+    if(isElse)
+    {
+      elseRule[lhs] = rules.size() - 1;
+    }
+  }
+
+  for(unsigned int r = 0; r < rules.size(); r++)
+  {
+    for(unsigned int i = 0; i < rules[r].symbols.size(); i++)
+    {
+      string name = bare(rules[r].symbols[i]);
+      bool known = isToken(name) ? shown.count(name) > 0 : numbers.count(name) > 0;
+      if(!known)
+      {
+        fail("Unknown name " + name + " in " + filename);
+      }
+    }
+  }
+  if(names.empty())
+  {
+    fail("No rules in " + filename);
+  }
+}
+
+/* Splits a line into words. Quoted text is one word, with \n read
+ * as a newline. A # starts a comment.
+ */
+vector<string> splitLine(string line, int lineNum)
+{
+  vector<string> words;
+  unsigned int i = 0;
+  while(i < line.length())
+  {
+    if(line[i] == ' ' || line[i] == '\t' || line[i] == '\r')
+    {
+      i++;
+    }
+    else if(line[i] == '#')
+    {
+      break;
+    }
+    else if(line[i] == '"')
+    {
+      string word;
+      for(i++; i < line.length() && line[i] != '"'; i++)
+      {
+        if(line[i] == '\\' && i + 1 < line.length() && line[i + 1] == 'n')
+        {
+          word += '\n';
+          i++;
+        }
+        else
+        {
+          word += line[i];
+        }
+      }
+      if(i == line.length())
+      {
+        stringstream message;
+        message << "Unterminated quote on line " << lineNum;
+        fail(message.str());
+      }
+      i++;
+      words.push_back(word);
+    }
+    else
+    {
+      string word;
+      for(; i < line.length() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r'; i++)
+      {
+        word += line[i];
+      }
+      words.push_back(word);
+    }
+  }
+  return words;
+}
+
+/* Number of a nonterminal, added the first time its name is seen.
+ */
+int nonterminal(string name)
+{
+  map<string, int>::iterator it = numbers.find(name);
+  if(it != numbers.end())
+  {
+    return it->second;
+  }
+  if(isToken(name))
+  {
+    fail("A token cannot have rules: " + name);
+  }
+  numbers[name] = names.size();
+  names.push_back(name);
+  elseRule.push_back(-1);
+  errorLabel.push_back("");
+  errorExpected.push_back("");
+  return names.size() - 1;
+}
+
+/* True if a name, without any !, is a token.
+ */
+bool isToken(string name)
+{
+  name = bare(name);
+  return name.length() > 3 && name.compare(name.length() - 3, 3, "_tk") == 0;
+}
+
+/* A name without the ! that keeps a token.
+ */
+string bare(string name)
+{
+  if(!name.empty() && name[name.length() - 1] == '!')
+  {
+    return name.substr(0, name.length() - 1);
+  }
+  return name;
+}
+
+/* Finds which nonterminals can be empty, then FIRST and FOLLOW of
+ * each, going over the rules until nothing more is added.
+ */
+void findSets()
+{
+  nullable.assign(names.size(), false);
+  first.assign(names.size(), set<string>());
+  follow.assign(names.size(), set<string>());
+
+  bool changed = true;
+  while(changed)
+  {
+    changed = false;
+    for(unsigned int r = 0; r < rules.size(); r++)
+    {
+      int lhs = rules[r].lhs;
+      unsigned int before = first[lhs].size();
+      bool empty = firstOf(rules[r].symbols, 0, first[lhs]);
+      if(empty && !nullable[lhs])
+      {
+        nullable[lhs] = true;
+        changed = true;
+      }
+      changed = changed || first[lhs].size() != before;
+    }
+  }
+
+  follow[0].insert("EOF_tk");
+  changed = true;
+  while(changed)
+  {
+    changed = false;
+    for(unsigned int r = 0; r < rules.size(); r++)
+    {
+      vector<string> &symbols = rules[r].symbols;
+      for(unsigned int i = 0; i < symbols.size(); i++)
+      {
+        if(isToken(symbols[i]))
+        {
+          continue;
+        }
+        int at = numbers[symbols[i]];
+        unsigned int before = follow[at].size();
+        if(firstOf(symbols, i + 1, follow[at]))
+        {
+          follow[at].insert(follow[rules[r].lhs].begin(), follow[rules[r].lhs].end());
+        }
+        changed = changed || follow[at].size() != before;
+      }
+    }
+  }
+}
+
+/* Adds FIRST of the symbols from start on to into. True if they
+ * can all be empty.
+ */
+bool firstOf(const vector<string> &symbols, unsigned int start, set<string> &into)
+{
+  for(unsigned int i = start; i < symbols.size(); i++)
+  {
+    if(isToken(symbols[i]))
+    {
+      into.insert(bare(symbols[i]));
+      return false;
+    }
+    int at = numbers[symbols[i]];
+    into.insert(first[at].begin(), first[at].end());
+    if(!nullable[at])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Fills the table and writes every array to the output header.
+ */
+void writeTables(string filename)
+{
+  vector<vector<int> > table(names.size(), vector<int>(tokens.size(), -1));
+  for(unsigned int r = 0; r < rules.size(); r++)
+  {
+    int lhs = rules[r].lhs;
+    set<string> under;
+    if(firstOf(rules[r].symbols, 0, under))
+    {
+      under.insert(follow[lhs].begin(), follow[lhs].end());
+    }
+    for(unsigned int t = 0; t < tokens.size(); t++)
+    {
+      if(under.count(tokens[t]) == 0)
+      {
+        continue;
+      }
+      if(table[lhs][t] >= 0 && table[lhs][t] != (int)r)
+      {
+        fail("Grammar is not LL(1): " + names[lhs] + " has two alternatives for " + tokens[t]);
+      }
+      table[lhs][t] = r;
+    }
+  }
+
+  stringstream out;
+  out << "/****************************\n"
+      << " * Generated by llgen from grammar.ll, do not edit.\n"
+      << " *\n"
+      << " * Tables for llParser.cpp.\n"
+      << " */\n\n"
+      << "#ifndef LLTABLES_H\n#define LLTABLES_H\n\n"
+      << "#include \"token.h\"\n"
+      << "#include <stddef.h>\n\n"
+      << "static constexpr int LL_TOKENS = " << tokens.size() << ";\n"
+      << "static constexpr int LL_NONTERMINALS = " << names.size() << ";\n"
+      << "static constexpr int LL_RULES = " << rules.size() << ";\n"
+      << "static constexpr int LL_NT = LL_TOKENS;\t// First nonterminal, the start\n"
+      << "static constexpr int LL_KEEP = LL_NT + LL_NONTERMINALS;\t// Added to a token kept\n\n";
+
+  out << "// Label of the node each nonterminal builds, or NULL for none.\n"
+      << "static constexpr const char *llLabels[LL_NONTERMINALS] = {";
+  for(unsigned int n = 0; n < names.size(); n++)
+  {
+    out << (n ? ", " : "") << (names[n][0] == '_' ? "NULL" : "\"" + names[n] + "\"");
+  }
+  out << "};\n\n";
+
+  out << "// Alternative to take for each nonterminal and token, -1 for an error.\n"
+      << "static constexpr short llTable[LL_NONTERMINALS][LL_TOKENS] = {\n";
+  for(unsigned int n = 0; n < names.size(); n++)
+  {
+    out << "  {";
+    for(unsigned int t = 0; t < tokens.size(); t++)
+    {
+      int take = table[n][t] >= 0 || !errorLabel[n].empty() ? table[n][t] : elseRule[n];
+      out << (t ? ", " : "") << take;
+    }
+    out << "}" << (n + 1 < names.size() ? "," : "") << "\t// " << names[n] << "\n";
+  }
+  out << "};\n\n";
+
+  // Nonterminals without an else error name the tokens they start with.
+  out << "// Error printed when a nonterminal has no alternative for a token.\n"
+      << "static constexpr const char *llErrorLabels[LL_NONTERMINALS] = {";
+  for(unsigned int n = 0; n < names.size(); n++)
+  {
+    string label = errorLabel[n].empty() ? names[n] : errorLabel[n];
+    out << (n ? ", " : "") << "\"" << escape(label) << "\"";
+  }
+  out << "};\n"
+      << "static constexpr const char *llErrorExpected[LL_NONTERMINALS] = {";
+  for(unsigned int n = 0; n < names.size(); n++)
+  {
+    string expected = errorExpected[n];
+    if(errorLabel[n].empty())
+    {
+      set<string>::iterator it = first[n].begin();
+      for(; it != first[n].end(); it++)
+      {
+        expected += (expected.empty() ? "" : ", ") + shown[*it];
+      }
+    }
+    out << (n ? ", " : "") << "\"" << escape(expected) << "\"";
+  }
+  out << "};\n\n";
+
+  out << "// How each token is named when it was expected.\n"
+      << "static constexpr const char *llShown[LL_TOKENS] = {";
+  for(unsigned int t = 0; t < tokens.size(); t++)
+  {
+    out << (t ? ", " : "") << "\"" << escape(shown[tokens[t]]) << "\"";
+  }
+  out << "};\n\n";
+
+  out << "// Symbols of every alternative, those of alternative r from\n"
+      << "// llStarts[r] up to llStarts[r + 1]. Tokens are their tokenID,\n"
+      << "// plus LL_KEEP if kept, and nonterminals are LL_NT plus their number.\n"
+      << "static constexpr short llStarts[LL_RULES + 1] = {";
+  int count = 0;
+  for(unsigned int r = 0; r <= rules.size(); r++)
+  {
+    out << (r ? ", " : "") << count;
+    if(r < rules.size())
+    {
+      count += rules[r].symbols.size();
+    }
+  }
+  out << "};\n"
+      << "static constexpr short llSymbols[" << max(count, 1) << "] = {";
+  bool any = false;
+  for(unsigned int r = 0; r < rules.size(); r++)
+  {
+    for(unsigned int i = 0; i < rules[r].symbols.size(); i++)
+    {
+      string name = rules[r].symbols[i];
+      out << (any ? ", " : "");
+      if(isToken(name))
+      {
+        out << (name.compare(bare(name)) != 0 ? "LL_KEEP + " : "") << bare(name);
+      }
+      else
+      {
+        out << "LL_NT + " << numbers[name];
+      }
+      any = true;
+    }
+  }
+  out << (any ? "" : "0") << "};\n\n#endif\n";
+
+  ofstream file(filename.c_str());
+  if(!file.is_open())
+  {
+    fail("Unable to write to " + filename);
+  }
+  file << out.str();
+}
+
+/* Writes text the way a C++ string literal needs it.
+ */
+string escape(string text)
+{
+  string escaped;
+  for(unsigned int i = 0; i < text.length(); i++)
+  {
+    if(text[i] == '\n')
+    {
+      escaped += "\\n";
+    }
+    else
+    {
+      if(text[i] == '"' || text[i] == '\\')
+      {
+        escaped += '\\';
+      }
+      escaped += text[i];
+    }
+  }
+  return escaped;
+}
+
+/* Prints what is wrong and exits.
+ */
+void fail(string message)
+{
+  cout << "llgen: " << message << endl;
+  exit(1);
+}
@@ -0,0 +1,33 @@
+LOAD 1
+STORE x
+WRITE x
+LOAD 2
+STORE x
+WRITE x
+LOAD 3
+STORE x
+WRITE x
+LOAD 4
+STORE x
+WRITE x
+LOAD 5
+STORE x
+WRITE x
+LOAD 6
+STORE x
+WRITE x
+LOAD 7
+STORE x
+WRITE x
+LOAD 8
+STORE x
+WRITE x
+LOAD 9
+STORE x
+WRITE x
+LOAD 10
+STORE T0
+WRITE T0
+STOP
+T0 0
+x 0
@@ -0,0 +1,353 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Lowers a finished VirtMach program to GNU assembler source for
+ * x86-64 Linux, written by comp --target=x86_64. The result needs
+ * no C library and builds with
+ * 	gcc -nostdlib -static -o prog prog.s
+ * or as and ld directly.
+ *
+ * The accumulator lives in eax and every variable is a 32 bit
+ * .long named v_ and its VirtMach name, so each instruction maps to
+ * one or a few machine instructions as in jit.cpp. Labels are .L
+ * and the index of the instruction they are on.
+ *
+ * The runtime after the program does READ and WRITE with read and
+ * write system calls, buffering both sides. Output is flushed before
+ * each READ so prompts still appear in order. Failed input and
+ * division by zero print the same errors as vmsim and exit with 1.
+ */
+
+#include "native.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Everything the generated code calls, all using sp_ names:
+// sp_read with the variable address in rdi, sp_write with the value
+// in edi, and the exits. Both calls keep eax and use only registers
+// the generated code does not.
+static const char RUNTIME[] =
+  "\n"
+  "# Runtime for READ and WRITE through Linux system calls.\n"
+  "\t.text\n"
+  "sp_stop:\n"
+  "\tcall sp_flush\n"
+  "\tmovl $60, %eax\t\t\t# exit(0)\n"
+  "\txorl %edi, %edi\n"
+  "\tsyscall\n"
+  "\n"
+  "sp_input:\n"
+  "\tleaq sp_input_msg(%rip), %rsi\n"
+  "\tmovl $sp_input_end - sp_input_msg, %edx\n"
+  "\tjmp sp_fail\n"
+  "\n"
+  "sp_divide:\n"
+  "\tleaq sp_divide_msg(%rip), %rsi\n"
+  "\tmovl $sp_divide_end - sp_divide_msg, %edx\n"
+  "\n"
+  "sp_fail:\t\t\t\t# message in rsi, length in edx\n"
+  "\tpushq %rsi\n"
+  "\tpushq %rdx\n"
+  "\tcall sp_flush\n"
+  "\tpopq %rdx\n"
+  "\tpopq %rsi\n"
+  "\tmovl $1, %eax\t\t\t# write(1, message, length)\n"
+  "\tmovl $1, %edi\n"
+  "\tsyscall\n"
+  "\tmovl $60, %eax\t\t\t# exit(1)\n"
+  "\tmovl $1, %edi\n"
+  "\tsyscall\n"
+  "\n"
+  "sp_read:\t\t\t\t# reads an integer into (rdi)\n"
+  "\tpushq %rax\n"
+  "\tpushq %rbx\n"
+  "\tpushq %r12\n"
+  "\tmovq %rdi, %rbx\n"
+  "\tcall sp_flush\n"
+  "1:\tcall sp_peek\t\t\t# skip white space\n"
+  "\tcmpl $32, %eax\n"
+  "\tje 2f\n"
+  "\tleal -9(%rax), %ecx\t\t# \\t through \\r\n"
+  "\tcmpl $4, %ecx\n"
+  "\tja 3f\n"
+  "2:\tincl sp_in_pos(%rip)\n"
+  "\tjmp 1b\n"
+  "3:\txorl %r12d, %r12d\t\t# 1 when negative\n"
+  "\tcmpl $43, %eax\t\t\t# '+'\n"
+  "\tje 4f\n"
+  "\tcmpl $45, %eax\t\t\t# '-'\n"
+  "\tjne 5f\n"
+  "\tincl %r12d\n"
+  "4:\tincl sp_in_pos(%rip)\n"
+  "\tcall sp_peek\n"
+  "5:\tleal -48(%rax), %ecx\t\t# at least one digit is needed\n"
+  "\tcmpl $9, %ecx\n"
+  "\tja sp_input\n"
+  "\tmovl $0, (%rbx)\n"
+  "6:\timull $10, (%rbx), %edx\n"
+  "\taddl %ecx, %edx\n"
+  "\tmovl %edx, (%rbx)\n"
+  "\tincl sp_in_pos(%rip)\n"
+  "\tcall sp_peek\n"
+  "\tleal -48(%rax), %ecx\n"
+  "\tcmpl $9, %ecx\n"
+  "\tjbe 6b\n"
+  "\ttestl %r12d, %r12d\n"
+  "\tjz 7f\n"
+  "\tnegl (%rbx)\n"
+  "7:\tpopq %r12\n"
+  "\tpopq %rbx\n"
+  "\tpopq %rax\n"
+  "\tret\n"
+  "\n"
+  "sp_peek:\t\t\t\t# next input byte in eax, -1 at the end\n"
+  "\tmovl sp_in_pos(%rip), %ecx\n"
+  "\tcmpl sp_in_len(%rip), %ecx\n"
+  "\tjb 1f\n"
+  "\txorl %eax, %eax\t\t\t# read(0, sp_in_buf, 4096)\n"
+  "\txorl %edi, %edi\n"
+  "\tleaq sp_in_buf(%rip), %rsi\n"
+  "\tmovl $4096, %edx\n"
+  "\tsyscall\n"
+  "\ttestq %rax, %rax\n"
+  "\tjle 2f\n"
+  "\tmovl %eax, sp_in_len(%rip)\n"
+  "\txorl %ecx, %ecx\n"
+  "\tmovl %ecx, sp_in_pos(%rip)\n"
+  "1:\tleaq sp_in_buf(%rip), %rdx\n"
+  "\tmovzbl (%rdx,%rcx), %eax\n"
+  "\tret\n"
+  "2:\tmovl $-1, %eax\n"
+  "\tret\n"
+  "\n"
+  "sp_write:\t\t\t\t# writes edi and a newline\n"
+  "\tpushq %rax\n"
+  "\tpushq %rdi\n"
+  "\tcmpl $4084, sp_out_len(%rip)\t# room for 12 more bytes\n"
+  "\tjbe 1f\n"
+  "\tcall sp_flush\n"
+  "1:\tpopq %rdi\n"
+  "\tsubq $16, %rsp\t\t\t# digits go backwards from the top\n"
+  "\tleaq 15(%rsp), %rsi\n"
+  "\tmovb $10, (%rsi)\n"
+  "\tmovl %edi, %eax\n"
+  "\ttestl %eax, %eax\n"
+  "\tjns 2f\n"
+  "\tnegl %eax\t\t\t# the most negative value works unsigned\n"
+  "2:\tmovl $10, %ecx\n"
+  "3:\txorl %edx, %edx\n"
+  "\tdivl %ecx\n"
+  "\taddl $48, %edx\n"
+  "\tdecq %rsi\n"
+  "\tmovb %dl, (%rsi)\n"
+  "\ttestl %eax, %eax\n"
+  "\tjnz 3b\n"
+  "\ttestl %edi, %edi\n"
+  "\tjns 4f\n"
+  "\tdecq %rsi\n"
+  "\tmovb $45, (%rsi)\n"
+  "4:\tleaq 16(%rsp), %rcx\n"
+  "\tsubq %rsi, %rcx\n"
+  "\tmovl sp_out_len(%rip), %edx\n"
+  "\tleaq sp_out_buf(%rip), %rdi\n"
+  "\taddq %rdx, %rdi\n"
+  "\taddl %ecx, sp_out_len(%rip)\n"
+  "\trep movsb\n"
+  "\taddq $16, %rsp\n"
+  "\tpopq %rax\n"
+  "\tret\n"
+  "\n"
+  "sp_flush:\t\t\t\t# writes out everything buffered\n"
+  "\tpushq %rbx\n"
+  "\txorl %ebx, %ebx\n"
+  "1:\tmovl sp_out_len(%rip), %edx\n"
+  "\tsubl %ebx, %edx\n"
+  "\tjle 2f\n"
+  "\tmovl $1, %eax\t\t\t# write(1, sp_out_buf + done, left)\n"
+  "\tmovl $1, %edi\n"
+  "\tleaq sp_out_buf(%rip), %rsi\n"
+  "\taddq %rbx, %rsi\n"
+  "\tsyscall\n"
+  "\ttestq %rax, %rax\n"
+  "\tjle 2f\t\t\t\t# output was closed\n"
+  "\taddl %eax, %ebx\n"
+  "\tjmp 1b\n"
+  "2:\tmovl $0, sp_out_len(%rip)\n"
+  "\tpopq %rbx\n"
+  "\tret\n"
+  "\n"
+  "\t.section .rodata\n"
+  "sp_input_msg:\n"
+  "\t.ascii \"\\nVM ERROR: Unable to read input for 'READ'.\\n\\n\"\n"
+  "sp_input_end:\n"
+  "sp_divide_msg:\n"
+  "\t.ascii \"\\nVM ERROR: Division by zero 'DIV'.\\n\\n\"\n"
+  "sp_divide_end:\n"
+  "\n"
+  "\t.bss\n"
+  "\t.balign 4\n"
+  "sp_in_pos:\t.space 4\n"
+  "sp_in_len:\t.space 4\n"
+  "sp_out_len:\t.space 4\n"
+  "sp_in_buf:\t.space 4096\n"
+  "sp_out_buf:\t.space 4096\n"
+  "\n"
+  "\t.section .note.GNU-stack,\"\",@progbits\n";
+
+/* Writes a loaded program as a complete assembler file,
+ * followed by its data and the runtime.
+ */
+void writeNative(ostream &out, const program &prog)
+{
+  vector<bool> targets(prog.code.size(), false);
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    const instr &cur = prog.code[i];
+    if(cur.op >= BR_op && cur.op <= BRZERO_op)
+    {
+      targets[cur.arg] = true;
+    }
+  }
+
+  out << "# Generated by comp --target=x86_64\n";
+  out << "\t.text\n";
+  out << "\t.globl _start\n";
+  out << "_start:\n";
+  out << "\txorl %eax, %eax\n";
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    if(targets[i])
+    {
+      out << ".L" << i << ":\n";
+    }
+    nativeInstr(out, prog, prog.code[i]);
+  }
+  out << "\tjmp sp_stop\n";
+
+  out << "\n\t.data\n";
+  out << "\t.balign 4\n";
+  for(unsigned int i = 0; i < prog.data.size(); i++)
+  {
+    out << "v_" << prog.names[i] << ":\t.long " << prog.data[i] << endl;
+  }
+  out << RUNTIME;
+}
+
+/* Writes the machine instructions for one VirtMach instruction,
+ * after a comment with the original.
+ */
+void nativeInstr(ostream &out, const program &prog, const instr &cur)
+{
+  string arg = nativeArg(prog, cur);
+  out << "\t\t\t\t\t# " << opName(cur.op);
+  if(cur.op >= BR_op && cur.op <= BRZERO_op)
+  {
+    out << " .L" << cur.arg;
+  }
+  else if(cur.immediate)
+  {
+    out << " " << cur.arg;
+  }
+  else if(cur.op != NOOP_op && cur.op != STOP_op)
+  {
+    out << " " << prog.names[cur.arg];
+  }
+  out << endl;
+
+  switch(cur.op)
+  {
+  case READ_op:
+    out << "\tleaq " << arg << ", %rdi\n";
+    out << "\tcall sp_read\n";
+    break;
+  case WRITE_op:
+    out << "\tmovl " << arg << ", %edi\n";
+    out << "\tcall sp_write\n";
+    break;
+  case LOAD_op:
+    out << "\tmovl " << arg << ", %eax\n";
+    break;
+  case STORE_op:
+    out << "\tmovl %eax, " << arg << endl;
+    break;
+  case ADD_op:
+    out << "\taddl " << arg << ", %eax\n";
+    break;
+  case SUB_op:
+    out << "\tsubl " << arg << ", %eax\n";
+    break;
+  case MULT_op:
+    out << "\timull " << arg << (cur.immediate ? ", %eax, %eax\n" : ", %eax\n");
+    break;
+  case DIV_op:
+    // idiv faults on the most negative value over -1, so dividing
+    // by -1 negates instead. Known divisors need no checks.
+    if(cur.immediate && cur.arg == 0)
+    {
+      out << "\tjmp sp_divide\n";
+    }
+    else if(cur.immediate && cur.arg == -1)
+    {
+      out << "\tnegl %eax\n";
+    }
+    else if(cur.immediate)
+    {
+      out << "\tmovl " << arg << ", %ecx\n";
+      out << "\tcltd\n";
+      out << "\tidivl %ecx\n";
+    }
+    else
+    {
+      out << "\tmovl " << arg << ", %ecx\n";
+      out << "\ttestl %ecx, %ecx\n";
+      out << "\tjz sp_divide\n";
+      out << "\tcmpl $-1, %ecx\n";
+      out << "\tjne 1f\n";
+      out << "\tnegl %eax\n";
+      out << "\tjmp 2f\n";
+      out << "1:\tcltd\n";
+      out << "\tidivl %ecx\n";
+      out << "2:\n";
+    }
+    break;
+  case BR_op:
+    out << "\tjmp .L" << cur.arg << endl;
+    break;
+  case BRNEG_op:
+  case BRZNEG_op:
+  case BRPOS_op:
+  case BRZPOS_op:
+  case BRZERO_op:
+    out << "\ttestl %eax, %eax\n";
+    out << (cur.op == BRNEG_op ? "\tjs" : cur.op == BRZNEG_op ? "\tjle"
+            : cur.op == BRPOS_op ? "\tjg" : cur.op == BRZPOS_op ? "\tjns" : "\tje");
+    out << " .L" << cur.arg << endl;
+    break;
+  case NOOP_op:
+    break;
+  case STOP_op:
+    out << "\tjmp sp_stop\n";
+    break;
+  }
+}
+
+/* Gives the operand for an instruction's argument, either an
+ * immediate or the variable it names.
+ */
+string nativeArg(const program &prog, const instr &cur)
+{
+  stringstream arg;
+  if(cur.immediate)
+  {
+    arg << "$" << cur.arg;
+  }
+  else if(cur.op < BR_op)
+  {
+    arg << "v_" << prog.names[cur.arg] << "(%rip)";
+  }
+  return arg.str();
+}
@@ -0,0 +1,19 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for native.cpp.
+ */
+
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include "virtMach.h"
+#include <ostream>
+#include <string>
+
+void writeNative(std::ostream &, const program &);
+void nativeInstr(std::ostream &, const program &, const instr &);
+std::string nativeArg(const program &, const instr &);
+
+#endif
@@ -0,0 +1,745 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Optimizes generated code before it is written to .asm.
+ *
+ * Lines are split into basic blocks, which start on a label or
+ * after a branch and end on a branch or before the next label.
+ * Constants and copies are propagated forward over the blocks,
+ * starting from the initial values in the data section. Only
+ * blocks some executable branch can reach are followed, so a
+ * condition known at compile time folds into BR or disappears
+ * along with the code it skips. READ always gives an unknown value.
+ * Liveness of every variable and the accumulator is found over
+ * the blocks, and instructions whose results are never used are
+ * removed. Variables no instruction refers to anymore are then
+ * dropped from the data section.
+ *
+ * Programs that never read input can also be run here, in which
+ * case the whole program becomes the WRITEs of its output.
+ */
+
+#include "optimize.h"
+#include "virtMach.h"
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <climits>
+#include <stdlib.h>
+using namespace std;
+
+// Liveness index of the accumulator, variables follow it.
+static const int ACC = 0;
+// Propagation and dead code removal feed each other, but stop
+// after this many rounds in case they keep finding small changes.
+static const int OPT_ROUNDS = 10;
+
+/* Auxiliary function for optimizing. Takes the generated lines
+ * and the declared and temporary variables with initial values.
+ */
+void optimizeCode(vector<asmLine> &code, map<string, int> &data)
+{
+  // Removing one instruction can leave the ones feeding it unused,
+  // so repeat until nothing changes. Propagation leaves stores
+  // unused and removal can leave loads of constants behind.
+  bool changed = true;
+  for(int round = 0; changed && round < OPT_ROUNDS; round++)
+  {
+    changed = propagateValues(code, data);
+    while(removeDeadCode(code))
+    {
+      changed = true;
+    }
+  }
+  pruneData(code, data);
+}
+
+/* Sparse conditional propagation of constants and copies. Every
+ * reached block gets what is known about each variable and the
+ * accumulator on entry, merged over the branches that can actually
+ * be taken into it. Known values then replace variable arguments,
+ * loads and stores that change nothing are removed, conditional
+ * branches on a known accumulator become BR or are dropped, and
+ * blocks never reached are removed.
+ * Returns true if any line changed.
+ */
+bool propagateValues(vector<asmLine> &code, map<string, int> &data)
+{
+  // Declared variables start with their initial values, anything
+  // missing from the data section is left unknown.
+  map<string, int> index;
+  vector<string> names(1, "");
+  propValue unknown = {VARIES_val, 0};
+  vector<propValue> entry(1, unknown);
+  map<string, int>::iterator it = data.begin();
+  while(it != data.end())
+  {
+    propValue initial = {CONST_val, it->second};
+    index.insert(pair<string, int>(it->first, names.size()));
+    names.push_back(it->first);
+    entry.push_back(initial);
+    it++;
+  }
+  for(unsigned int i = 0; i < code.size(); i++)
+  {
+    if(!isBranch(code[i].op) && isVariable(code[i].arg)
+       && index.find(code[i].arg) == index.end())
+    {
+      index.insert(pair<string, int>(code[i].arg, names.size()));
+      names.push_back(code[i].arg);
+      entry.push_back(unknown);
+    }
+  }
+  int size = names.size();
+
+  vector<int> starts;
+  vector<vector<int> > succ;
+  findBlocks(code, starts, succ);
+  int blocks = starts.size();
+  starts.push_back(code.size());
+  map<string, int> labelBlock;
+  for(int b = 0; b < blocks; b++)
+  {
+    if(!code[starts[b]].label.empty())
+    {
+      labelBlock.insert(pair<string, int>(code[starts[b]].label, b));
+    }
+  }
+
+  propValue unset = {UNSET_val, 0};
+  vector<vector<propValue> > in(blocks, vector<propValue>(size, unset));
+  vector<bool> reached(blocks, false);
+  vector<int> work;
+  in[0] = entry;
+  reached[0] = true;
+  work.push_back(0);
+  while(!work.empty())
+  {
+    int b = work.back();
+    work.pop_back();
+    vector<propValue> state = in[b];
+    for(int i = starts[b]; i < starts[b + 1]; i++)
+    {
+      propStep(code[i], state, index);
+    }
+
+    // Only follow the branch the accumulator picks when it is known.
+    asmLine &last = code[starts[b + 1] - 1];
+    int target = -1;
+    if(isBranch(last.op) && labelBlock.find(last.arg) != labelBlock.end())
+    {
+      target = labelBlock[last.arg];
+    }
+    vector<int> next;
+    if(last.op.compare("BR") == 0)
+    {
+      next.push_back(target);
+    }
+    else if(isBranch(last.op) && state[ACC].type == CONST_val)
+    {
+      next.push_back(branchTaken(last.op, state[ACC].num) ? target : b + 1);
+    }
+    else if(isBranch(last.op))
+    {
+      next.push_back(target);
+      next.push_back(b + 1);
+    }
+    else if(last.op.compare("STOP") != 0)
+    {
+      next.push_back(b + 1);
+    }
+
+    for(unsigned int n = 0; n < next.size(); n++)
+    {
+      int to = next[n];
+      if(to < 0 || to >= blocks)
+      {
+        continue;
+      }
+      bool grew = !reached[to];
+      for(int v = 0; v < size; v++)
+      {
+        propValue merged = reached[to] ? meetValue(in[to][v], state[v]) : state[v];
+        if(!sameValue(merged, in[to][v]))
+        {
+          in[to][v] = merged;
+          grew = true;
+        }
+      }
+      reached[to] = true;
+      if(grew)
+      {
+        work.push_back(to);
+      }
+    }
+  }
+
+  // Rewrite reached blocks with what is known before each line.
+  bool changed = false;
+  vector<asmLine> kept;
+  for(int b = 0; b < blocks; b++)
+  {
+    if(!reached[b])
+    {
+      changed = true;
+      continue;
+    }
+    vector<propValue> state = in[b];
+    for(int i = starts[b]; i < starts[b + 1]; i++)
+    {
+      asmLine line = code[i];
+      string op = line.op;
+      bool drop = false;
+      if(op.compare("STORE") == 0)
+      {
+        drop = sameValue(argValue(line.arg, state, index), state[ACC]);
+      }
+      else if(op.compare("LOAD") == 0 || op.compare("ADD") == 0
+              || op.compare("SUB") == 0 || op.compare("MULT") == 0
+              || op.compare("DIV") == 0 || op.compare("WRITE") == 0)
+      {
+        propValue arg = argValue(line.arg, state, index);
+        int result;
+        if(op.compare("LOAD") == 0 && sameValue(arg, state[ACC]))
+        {
+          drop = true;
+        }
+        else if(state[ACC].type == CONST_val && arg.type == CONST_val
+                && foldOp(op, state[ACC].num, arg.num, result))
+        {
+          stringstream num;
+          num << result;
+          line.op = "LOAD";
+          line.arg = num.str();
+        }
+        // WRITE keeps a variable, the machine only prints from memory.
+        else if(arg.type == CONST_val && op.compare("WRITE") != 0)
+        {
+          stringstream num;
+          num << arg.num;
+          line.arg = num.str();
+        }
+        else if(arg.type == COPY_val)
+        {
+          line.arg = names[arg.num];
+        }
+      }
+      else if(isBranch(op) && op.compare("BR") != 0 && state[ACC].type == CONST_val)
+      {
+        if(branchTaken(op, state[ACC].num))
+        {
+          line.op = "BR";
+        }
+        else
+        {
+          drop = true;
+        }
+      }
+      propStep(code[i], state, index);
+
+      // A label still needs a line to sit on.
+      if(drop && !line.label.empty())
+      {
+        line.op = "NOOP";
+        line.arg = "";
+        drop = false;
+      }
+      if(drop || line.op.compare(code[i].op) != 0 || line.arg.compare(code[i].arg) != 0)
+      {
+        changed = true;
+      }
+      if(!drop)
+      {
+        kept.push_back(line);
+      }
+    }
+  }
+
+  // Branching to the very next line does nothing either way, and
+  // a NOOP no branch goes to is only there to hold its label.
+  set<string> targets;
+  for(unsigned int i = 0; i < kept.size(); i++)
+  {
+    if(isBranch(kept[i].op))
+    {
+      targets.insert(kept[i].arg);
+    }
+  }
+  vector<asmLine> cleaned;
+  for(unsigned int i = 0; i < kept.size(); i++)
+  {
+    if((isBranch(kept[i].op) && kept[i].label.empty() && i + 1 < kept.size()
+        && kept[i].arg.compare(kept[i + 1].label) == 0)
+       || (kept[i].op.compare("NOOP") == 0 && targets.count(kept[i].label) == 0))
+    {
+      changed = true;
+      continue;
+    }
+    cleaned.push_back(kept[i]);
+  }
+  code.swap(cleaned);
+  return changed;
+}
+
+/* Updates state, moving forwards over one instruction.
+ */
+void propStep(asmLine &line, vector<propValue> &state, map<string, int> &index)
+{
+  string op = line.op;
+  if(op.compare("LOAD") == 0)
+  {
+    state[ACC] = argValue(line.arg, state, index);
+  }
+  else if(op.compare("STORE") == 0)
+  {
+    int var = index[line.arg];
+    propValue acc = state[ACC];
+    // Storing a variable back into itself changes nothing.
+    if(acc.type == COPY_val && acc.num == var)
+    {
+      return;
+    }
+    forgetCopies(var, state);
+    state[var] = acc;
+    if(acc.type == VARIES_val)
+    {
+      state[ACC].type = COPY_val;
+      state[ACC].num = var;
+    }
+  }
+  else if(op.compare("READ") == 0)
+  {
+    int var = index[line.arg];
+    forgetCopies(var, state);
+    state[var].type = VARIES_val;
+  }
+  else if(op.compare("ADD") == 0 || op.compare("SUB") == 0
+          || op.compare("MULT") == 0 || op.compare("DIV") == 0)
+  {
+    propValue arg = argValue(line.arg, state, index);
+    int result;
+    if(state[ACC].type == CONST_val && arg.type == CONST_val
+       && foldOp(op, state[ACC].num, arg.num, result))
+    {
+      state[ACC].num = result;
+    }
+    else
+    {
+      state[ACC].type = VARIES_val;
+    }
+  }
+}
+
+/* What is known about an instruction argument. A variable with no
+ * known value or copy is at least equal to itself.
+ */
+propValue argValue(string arg, vector<propValue> &state, map<string, int> &index)
+{
+  propValue result;
+  if(!isVariable(arg))
+  {
+    result.type = CONST_val;
+    result.num = atoi(arg.c_str());
+    return result;
+  }
+  int var = index[arg];
+  if(state[var].type == CONST_val || state[var].type == COPY_val)
+  {
+    return state[var];
+  }
+  result.type = COPY_val;
+  result.num = var;
+  return result;
+}
+
+/* A variable is about to change, so nothing holds a copy of it anymore.
+ */
+void forgetCopies(int var, vector<propValue> &state)
+{
+  for(unsigned int v = 0; v < state.size(); v++)
+  {
+    if(state[v].type == COPY_val && state[v].num == var)
+    {
+      state[v].type = VARIES_val;
+    }
+  }
+}
+
+/* Merges what is known from two paths. Only what both agree on is kept.
+ */
+propValue meetValue(propValue a, propValue b)
+{
+  if(a.type == UNSET_val || sameValue(a, b))
+  {
+    return b;
+  }
+  if(b.type == UNSET_val)
+  {
+    return a;
+  }
+  propValue varies = {VARIES_val, 0};
+  return varies;
+}
+
+/* True if two values are known to be the same.
+ */
+bool sameValue(propValue a, propValue b)
+{
+  if(a.type != b.type)
+  {
+    return false;
+  }
+  return (a.type != CONST_val && a.type != COPY_val) || a.num == b.num;
+}
+
+/* Computes left op right as the machine would. Returns false for
+ * anything that does not give a result, like dividing by zero.
+ */
+bool foldOp(string op, int left, int right, int &result)
+{
+  // Wrap around on overflow instead of relying on signed overflow.
+  unsigned int a = left;
+  unsigned int b = right;
+  if(op.compare("ADD") == 0)
+  {
+    result = (int)(a + b);
+  }
+  else if(op.compare("SUB") == 0)
+  {
+    result = (int)(a - b);
+  }
+  else if(op.compare("MULT") == 0)
+  {
+    result = (int)(a * b);
+  }
+  else if(op.compare("DIV") == 0 && right != 0 && !(left == INT_MIN && right == -1))
+  {
+    result = left / right;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+/* True if a conditional branch is taken with acc in the accumulator.
+ */
+bool branchTaken(string op, int acc)
+{
+  if(op.compare("BRNEG") == 0)
+  {
+    return acc < 0;
+  }
+  if(op.compare("BRZNEG") == 0)
+  {
+    return acc <= 0;
+  }
+  if(op.compare("BRPOS") == 0)
+  {
+    return acc > 0;
+  }
+  if(op.compare("BRZPOS") == 0)
+  {
+    return acc >= 0;
+  }
+  if(op.compare("BRZERO") == 0)
+  {
+    return acc == 0;
+  }
+  return op.compare("BR") == 0;
+}
+
+/* Finds live variables at the end of every block, then walks each
+ * block backwards to remove stores to variables that are not read
+ * again and accumulator changes that are overwritten before use.
+ * READ is always kept since it consumes input.
+ * Returns true if anything was removed.
+ */
+bool removeDeadCode(vector<asmLine> &code)
+{
+  // Give every variable a liveness index after the accumulator.
+  map<string, int> index;
+  for(unsigned int i = 0; i < code.size(); i++)
+  {
+    if(!isBranch(code[i].op) && isVariable(code[i].arg)
+       && index.find(code[i].arg) == index.end())
+    {
+      int next = index.size() + 1;
+      index.insert(pair<string, int>(code[i].arg, next));
+    }
+  }
+  int size = index.size() + 1;
+
+  vector<int> starts;
+  vector<vector<int> > succ;
+  findBlocks(code, starts, succ);
+  int blocks = starts.size();
+  starts.push_back(code.size());
+
+  // Nothing is live after STOP, so everything starts empty.
+  vector<vector<bool> > liveIn(blocks, vector<bool>(size, false));
+  vector<vector<bool> > liveOut(blocks, vector<bool>(size, false));
+  bool changed = true;
+  while(changed)
+  {
+    changed = false;
+    for(int b = blocks - 1; b >= 0; b--)
+    {
+      vector<bool> live(size, false);
+      for(unsigned int s = 0; s < succ[b].size(); s++)
+      {
+        for(int v = 0; v < size; v++)
+        {
+          if(liveIn[succ[b][s]][v])
+          {
+            live[v] = true;
+          }
+        }
+      }
+      liveOut[b] = live;
+      for(int i = starts[b + 1] - 1; i >= starts[b]; i--)
+      {
+        liveStep(code[i], live, index);
+      }
+      if(live != liveIn[b])
+      {
+        liveIn[b] = live;
+        changed = true;
+      }
+    }
+  }
+
+  // Walk each block backwards from its live out set, skipping
+  // dead instructions so they do not keep their inputs alive.
+  vector<bool> remove(code.size(), false);
+  bool removed = false;
+  for(int b = 0; b < blocks; b++)
+  {
+    vector<bool> live = liveOut[b];
+    for(int i = starts[b + 1] - 1; i >= starts[b]; i--)
+    {
+      if(isDead(code[i], live, index))
+      {
+        remove[i] = true;
+        removed = true;
+      }
+      else
+      {
+        liveStep(code[i], live, index);
+      }
+    }
+  }
+
+  if(removed)
+  {
+    vector<asmLine> kept;
+    for(unsigned int i = 0; i < code.size(); i++)
+    {
+      if(!remove[i])
+      {
+        kept.push_back(code[i]);
+      }
+    }
+    code.swap(kept);
+  }
+  return removed;
+}
+
+/* Whole program partial evaluation. Runs the code in the simulator
+ * with no input and at most budget instructions. If it reaches STOP,
+ * the output is already known, so the code is replaced by one WRITE
+ * per value printed. Each distinct value gets a temporary variable
+ * holding it as an initial value.
+ * Returns false and leaves the code alone if the program tries to
+ * READ, runs out of budget, or divides by zero.
+ */
+bool evaluateProgram(vector<asmLine> &code, map<string, int> &data, long budget)
+{
+  program prog;
+  loadLines(code, data, prog);
+  stringstream out;
+  long count = 0;
+  if(execProgram(prog, NULL, out, budget, count) != STOP_run)
+  {
+    return false;
+  }
+
+  vector<asmLine> folded;
+  map<string, int> values;
+  map<int, string> names;
+  int value;
+  while(out >> value)
+  {
+    map<int, string>::iterator it = names.find(value);
+    if(it == names.end())
+    {
+      stringstream name;
+      name << "T" << names.size();
+      it = names.insert(pair<int, string>(value, name.str())).first;
+      values.insert(pair<string, int>(name.str(), value));
+    }
+    asmLine line;
+    line.op = "WRITE";
+    line.arg = it->second;
+    folded.push_back(line);
+  }
+  asmLine stop;
+  stop.op = "STOP";
+  folded.push_back(stop);
+
+  code.swap(folded);
+  data.swap(values);
+  return true;
+}
+
+/* Drops every declared or temporary variable that is no longer
+ * used by any instruction, shrinking the data section.
+ */
+void pruneData(vector<asmLine> &code, map<string, int> &data)
+{
+  map<string, int> used;
+  for(unsigned int i = 0; i < code.size(); i++)
+  {
+    if(!isBranch(code[i].op) && isVariable(code[i].arg))
+    {
+      map<string, int>::iterator it = data.find(code[i].arg);
+      if(it != data.end())
+      {
+        used.insert(*it);
+      }
+    }
+  }
+  data.swap(used);
+}
+
+/* Splits the code into basic blocks. Fills starts with the first
+ * line of every block and succ with the blocks each can go to next.
+ */
+void findBlocks(vector<asmLine> &code, vector<int> &starts, vector<vector<int> > &succ)
+{
+  vector<int> blockOf(code.size(), 0);
+  map<string, int> labels;
+  for(unsigned int i = 0; i < code.size(); i++)
+  {
+    bool leader = i == 0 || !code[i].label.empty() || isBranch(code[i - 1].op)
+                  || code[i - 1].op.compare("STOP") == 0;
+    if(leader)
+    {
+      starts.push_back(i);
+    }
+    blockOf[i] = starts.size() - 1;
+    if(!code[i].label.empty())
+    {
+      labels.insert(pair<string, int>(code[i].label, i));
+    }
+  }
+
+  succ.assign(starts.size(), vector<int>());
+  for(unsigned int b = 0; b < starts.size(); b++)
+  {
+    int last = (b + 1 < starts.size() ? starts[b + 1] : code.size()) - 1;
+    string op = code[last].op;
+    if(isBranch(op))
+    {
+      map<string, int>::iterator it = labels.find(code[last].arg);
+      if(it != labels.end())
+      {
+        succ[b].push_back(blockOf[it->second]);
+      }
+    }
+    // Everything but STOP and BR can continue to the next line.
+    if(op.compare("STOP") != 0 && op.compare("BR") != 0
+       && last + 1 < (int)code.size())
+    {
+      succ[b].push_back(b + 1);
+    }
+  }
+}
+
+/* Updates live, moving backwards over one instruction.
+ */
+void liveStep(asmLine &line, vector<bool> &live, map<string, int> &index)
+{
+  int var = -1;
+  if(!isBranch(line.op) && isVariable(line.arg))
+  {
+    var = index[line.arg];
+  }
+
+  if(line.op.compare("STORE") == 0)
+  {
+    live[var] = false;
+    live[ACC] = true;
+  }
+  else if(line.op.compare("READ") == 0)
+  {
+    live[var] = false;
+  }
+  else if(line.op.compare("WRITE") == 0)
+  {
+    live[var] = true;
+  }
+  else if(line.op.compare("LOAD") == 0)
+  {
+    live[ACC] = false;
+    if(var >= 0)
+    {
+      live[var] = true;
+    }
+  }
+  else if(line.op.compare("ADD") == 0 || line.op.compare("SUB") == 0
+          || line.op.compare("MULT") == 0 || line.op.compare("DIV") == 0)
+  {
+    live[ACC] = true;
+    if(var >= 0)
+    {
+      live[var] = true;
+    }
+  }
+  // Conditional branches test the accumulator.
+  else if(isBranch(line.op) && line.op.compare("BR") != 0)
+  {
+    live[ACC] = true;
+  }
+}
+
+/* True if an instruction only changes a variable or the
+ * accumulator that is not live afterwards. Labeled lines
+ * are always kept so branches still have somewhere to go.
+ */
+bool isDead(asmLine &line, vector<bool> &live, map<string, int> &index)
+{
+  if(!line.label.empty())
+  {
+    return false;
+  }
+  if(line.op.compare("STORE") == 0)
+  {
+    return !live[index[line.arg]];
+  }
+  if(line.op.compare("LOAD") == 0 || line.op.compare("ADD") == 0
+     || line.op.compare("SUB") == 0 || line.op.compare("MULT") == 0
+     || line.op.compare("DIV") == 0)
+  {
+    return !live[ACC];
+  }
+  return false;
+}
+
+/* True for BR and every conditional branch.
+ */
+bool isBranch(string op)
+{
+  return op.compare(0, 2, "BR") == 0;
+}
+
+/* True if an argument names a variable rather than an integer.
+ */
+bool isVariable(string arg)
+{
+  return !arg.empty() && !isdigit(arg[0]) && arg[0] != '-';
+}
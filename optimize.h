@@ -0,0 +1,46 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for optimize.cpp.
+ */
+
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include "asmLine.h"
+#include <string>
+#include <vector>
+#include <map>
+
+// What propagation knows about a variable or the accumulator.
+// UNSET_val is a block not reached yet, CONST_val holds num, and
+// COPY_val holds the same value as the variable at index num.
+typedef enum {UNSET_val, CONST_val, COPY_val, VARIES_val} valType;
+
+struct propValue
+{
+  valType type;
+  int num;
+};
+
+void optimizeCode(std::vector<asmLine> &, std::map<std::string, int> &);
+bool propagateValues(std::vector<asmLine> &, std::map<std::string, int> &);
+bool removeDeadCode(std::vector<asmLine> &);
+bool evaluateProgram(std::vector<asmLine> &, std::map<std::string, int> &, long);
+void pruneData(std::vector<asmLine> &, std::map<std::string, int> &);
+
+void findBlocks(std::vector<asmLine> &, std::vector<int> &, std::vector<std::vector<int> > &);
+void propStep(asmLine &, std::vector<propValue> &, std::map<std::string, int> &);
+propValue argValue(std::string, std::vector<propValue> &, std::map<std::string, int> &);
+void forgetCopies(int, std::vector<propValue> &);
+propValue meetValue(propValue, propValue);
+bool sameValue(propValue, propValue);
+bool foldOp(std::string, int, int, int &);
+bool branchTaken(std::string, int);
+void liveStep(asmLine &, std::vector<bool> &, std::map<std::string, int> &);
+bool isDead(asmLine &, std::vector<bool> &, std::map<std::string, int> &);
+bool isBranch(std::string);
+bool isVariable(std::string);
+
+#endif
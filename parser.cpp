@@ -22,7 +22,17 @@ using namespace std;
 // Stores a token object used across functions.
 // Several of them will need to access the next token
 // or the one left from the previous function.
-static token tk;
+// Each thread parsing statements on its own has one, see blocks.cpp.
+static thread_local token tk;
+// Given each declaration and statement of the outer block as soon
+// as it is complete, when set. Used by pipeline.cpp.
+static void (*parsedHook)(Node*) = NULL;
+static __thread int blockDepth = 0;	// Blocks the parser is inside of
+// Gives a <stat> of the outer block parsed ahead of time, or NULL
+// to parse it here. Used by blocks.cpp.
+static Node* (*aheadHook)() = NULL;
+// Ends a thread parsing ahead on an error, rather than printing it.
+static __thread void (*abortHook)() = NULL;
 
 /* Begins creating the parse tree. Creates the root node
  * and returns once the tree is finished. If the tree is
@@ -47,6 +57,68 @@ Node* parser()
   }
 }
 
+/* Sets a function given every piece of the program that is
+ * complete once parsed, in order: the <vars> of <program>, the
+ * <vars> of the outer <block>, then each <stat> of the outer block.
+ * The parser never changes a piece after handing it over.
+ */
+void setParsedHook(void (*hook)(Node*))
+{
+  parsedHook = hook;
+}
+
+/* Sets a function giving statements of the outer block that were
+ * parsed ahead of time, see outerStat.
+ */
+void setAheadHook(Node* (*hook)())
+{
+  aheadHook = hook;
+}
+
+/* Sets a function called on the calling thread in place of printing
+ * a parse error. It must not return.
+ */
+void setAbortHook(void (*hook)())
+{
+  abortHook = hook;
+}
+
+/* Parses one <stat> from the next token on, as if inside depth
+ * blocks, for threads parsing statements of a block on their own.
+ */
+Node* parseStat(int depth)
+{
+  blockDepth = depth;
+  tk = scanToken();
+  return stat();
+}
+
+/* Parses a <stat> of any block. One of the outer block may have
+ * been parsed ahead of time, in which case the hook has moved past
+ * its tokens and only the token after it is left to scan.
+ */
+Node* outerStat()
+{
+  Node* node = blockDepth == 1 && aheadHook ? aheadHook() : NULL;
+  if(node)
+  {
+    tk = scanToken();
+    return node;
+  }
+  return stat();
+}
+
+/* Hands a finished piece to the hook if it belongs to the block
+ * at depth, 0 meaning outside of every block.
+ */
+void parsedPiece(Node* piece, int depth)
+{
+  if(parsedHook && piece && blockDepth == depth)
+  {
+    parsedHook(piece);
+  }
+}
+
 /* FIRST(program) = FIRST(vars) = {DECLARE_tk, empty} U {OBRACE_tk}
  * Because empty is in the set, union with...
  * FIRST(block) = {OBRACE_tk}
@@ -60,6 +132,7 @@ Node* program()
   // and sets the children to vars and block appropriately.
   Node* node = getNode("program");
   node->child1 = vars();
+  parsedPiece(node->child1, 0);
 
   // vars can be empty, so block may end up as child 1 instead of 2.
   if(node->child1)
@@ -149,7 +222,9 @@ Node* block()
   case OBRACE_tk:
     //node->token1 = tk;
     tk = scanToken();
+    blockDepth++;
     node->child1 = vars();
+    parsedPiece(node->child1, 1);
 
     // As in program(), vars may be empty, which would
     // make stats the first child instead.
@@ -167,6 +242,7 @@ Node* block()
     {
     case CBRACE_tk:
       //node->token2 = tk;
+      blockDepth--;
       tk = scanToken();
       return node;
 
@@ -188,7 +264,8 @@ Node* stats()
 {
   Node* node = getNode("stats");
   // stat should not be empty, so no need to check if child1 is null
-  node->child1 = stat();
+  node->child1 = outerStat();
+  parsedPiece(node->child1, 1);
   node->child2 = mStat();
   return node;
 }
@@ -218,7 +295,8 @@ Node* mStat()
   case GOTO_tk:
   case LABEL_tk:
   case IFFY_tk:
-    node->child1 = stat();
+    node->child1 = outerStat();
+    parsedPiece(node->child1, 1);
     node->child2 = mStat();
     return node;
 
@@ -562,140 +640,124 @@ Node* goto_()
  * OPAREN_tk is "("
  * IDENT_tk is an identifier
  * NUM_tk is a number, or integer
+ *
+ * <expr> -> <N> - <expr> | <N>
+ * <N>    -> <A> / <N> | <A> * <N> | <A>
+ * <A>    -> <M> + <A> | <M>
+ * <M>    -> * <M> | <R>
+ * <R>    -> ( <expr> ) | IDENTIFIER | INTEGER
+ *
+ * Rather than a node for every one of these an operand passes
+ * through, only operators and operands get one, see exprLevel.
+ * Each operator keeps the label of the rule it comes from, with the
+ * operator as token1, and each operand is an <R> holding its token.
+ * Parentheses leave no node, the shape of the tree gives the order.
  */
 Node* expr()
 {
-  Node* node = getNode("expr");
   switch(tk.id)
   {
   case TIMES_tk:
   case OPAREN_tk:
   case IDENT_tk:
   case NUM_tk:
-    node->child1 = N();
-    
-    switch(tk.id)
-    {
-    case MINUS_tk:
-      node->token1 = tk;
-      tk = scanToken();
-      node->child2 = expr();
-      return node;
-
-    default:
-      return node;
-    }
+    return exprLevel(MINUS_LEVEL);
 
   default:
-    errorParse(node->label, "*, (, IDENTIFIER, or INTEGER");
+    errorParse("expr", "*, (, IDENTIFIER, or INTEGER");
   }
 }
 
-/* FIRST(N) = FIRST(A) has the same results as expr()
+/* Parses an expression of operators binding at least as tightly as
+ * least, by precedence climbing. - binds loosest, then * and /, then
+ * +. Every rule above has its operator on the right of the rule
+ * itself, so each operator groups to the right: the right side of
+ * one takes every operator after it binding as tightly or tighter.
+ * After a - that is a whole <expr>, checked again the way <expr> is.
  */
-Node* N()
+Node* exprLevel(int least)
 {
-  Node* node = getNode("N");
-  node->child1 = A();
-
-  switch(tk.id)
+  Node* left = operand();
+  int level = opLevel(tk.id);
+  while(level >= least)
   {
-  // <A> * <N> | <A> / <N>
-  case TIMES_tk:
-  case DIVIDE_tk:
+    string label = level == MINUS_LEVEL ? "expr" : level == TIMES_LEVEL ? "N" : "A";
+    Node* node = getNode(label);
     node->token1 = tk;
     tk = scanToken();
-    node->child2 = N();
-    return node;
-
-  // <A>
-  default:
-    return node;
+    node->child1 = left;
+    node->child2 = level == MINUS_LEVEL ? expr() : exprLevel(level);
+    left = node;
+    level = opLevel(tk.id);
   }
+  return left;
 }
 
-/* FIRST(A) = FIRST(M) has the same results as expr()
+/* How tightly a token binds as an operator after an operand,
+ * 0 if it is not one.
  */
-Node* A()
+int opLevel(tokenID id)
 {
-  Node* node = getNode("A");
-  node->child1 = M();
-
-  switch(tk.id)
+  switch(id)
   {
-  // <M> + <A>
+  case MINUS_tk:
+    return MINUS_LEVEL;
+  case TIMES_tk:
+  case DIVIDE_tk:
+    return TIMES_LEVEL;
   case PLUS_tk:
-    node->token1 = tk;
-    tk = scanToken();
-    node->child2 = A();
-    return node;
-
-  // <M>
+    return PLUS_LEVEL;
   default:
-    return node;
+    return 0;
   }
 }
 
-/* FIRST(M) has the same results as expr()
- * TIMES_tk stays in M
- * The other 3 shift to R
+/* Parses <M>, an <R> after any number of * negating it. Each * is an
+ * <M> node with the operand as its only child.
  */
-Node* M()
+Node* operand()
 {
-  Node* node = getNode("M");
   switch(tk.id)
   {
   // * <M>
   case TIMES_tk:
+  {
+    Node* node = getNode("M");
     node->token1 = tk;
     tk = scanToken();
-    node->child1 = M();
-    return node;
-
-  // <R>
-  default:
-    node->child1 = R();
+    node->child1 = operand();
     return node;
   }
-}
 
-/* FIRST(R) = {OPAREN_tk, IDENT_tk, NUM_tk}
- * OPAREN_tk is "("
- * IDENT_tk is an identifier
- * NUM_tk is a number, or integer
- */
-Node* R()
-{
-  Node* node = getNode("R");
-  switch(tk.id)
-  {
-  // ( <expr> ...
+  // ( <expr> ), the <expr> itself
   case OPAREN_tk:
-    //node->token1 = tk;
+  {
     tk = scanToken();
-    node->child1 = expr();
+    Node* node = expr();
 
     switch(tk.id)
     {
-    // ( <expr> )
     case CPAREN_tk:
-      //node->token2 = tk;
       tk = scanToken();
       return node;
 
     default:
-      errorParse(node->label, ")");
+      errorParse("R", ")");
     }
+  }
 
   // IDENTIFIER | INTEGER
   case IDENT_tk:
   case NUM_tk:
+  {
+    Node* node = getNode("R");
     node->token1 = tk;
     tk = scanToken();
     return node;
+  }
 
   default:
-    errorParse(node->label, "IDENTIFIER, INTEGER, or (");
+    errorParse("R", "IDENTIFIER, INTEGER, or (");
   }
 }
 
@@ -759,10 +821,22 @@ Node* RO()
 }
 
 void errorParse(string label, string expected)
+{
+  if(abortHook)
+  {
+    abortHook();
+  }
+  errorAt(tk, label, expected);
+}
+
+/* Prints a parse error at the token found and exits. Also used by
+ * the table-driven parser, which keeps its own token.
+ */
+void errorAt(token found, string label, string expected)
 {
   cout << endl;
-  cout << "ERROR: Building '" << label << "' on line " << tk.lineNum << "." << endl;
-  cout << "      Found '" << tk.tokenString << "', expected '" << expected << "'." << endl;
+  cout << "ERROR: Building '" << label << "' on line " << lineAt(found.offset) << "." << endl;
+  cout << "      Found '" << found.tokenString << "', expected '" << expected << "'." << endl;
   cout << endl;
   exit(1);
 }
@@ -10,9 +10,21 @@
 #define PARSER_H
 
 #include "node.h"
+#include "token.h"
 #include <string>
 
+// How tightly each operator binds, see exprLevel.
+static const int MINUS_LEVEL = 1;
+static const int TIMES_LEVEL = 2;
+static const int PLUS_LEVEL = 3;
+
 Node* parser();
+void setParsedHook(void (*)(Node*));
+void parsedPiece(Node*, int);
+void setAheadHook(Node* (*)());
+void setAbortHook(void (*)());
+Node* parseStat(int);
+Node* outerStat();
 Node* program();
 
 Node* vars();
@@ -32,12 +44,11 @@ Node* goto_();
 
 Node* RO();
 Node* expr();
-
-Node* N();
-Node* A();
-Node* M();
-Node* R();
+Node* exprLevel(int);
+int opLevel(tokenID);
+Node* operand();
 
 void errorParse(std::string, std::string);
+void errorAt(token, std::string, std::string);
 
 #endif
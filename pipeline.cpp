@@ -0,0 +1,212 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Runs the front of the compiler as a pipeline for comp --pipeline,
+ * so a large file keeps three processors busy instead of one.
+ *
+ * 	lexer thread  -> tokens -> parser (main thread)
+ * 	parser        -> pieces -> checking thread
+ *
+ * The lexer thread builds tokens with the driver and puts them in a
+ * ring the parser takes from through scanToken. Scanner warnings and
+ * errors travel through the same ring, so they are printed at the
+ * token the parser would have built them at. A scanner error stops
+ * the lexer thread, and the parser exits once it reaches the error.
+ *
+ * The parser hands every declaration and statement of the outer
+ * block to the checking thread as soon as it is complete. That
+ * thread checks its semantics and simplifies its expressions, which
+ * only depend on statements before it. Semantics errors are held
+ * until parsing is done, since a parse error would stop the compiler
+ * before semantics ever ran.
+ *
+ * The rest of code generation waits for the whole tree. Loop
+ * unrolling looks at declarations anywhere in the program, and the
+ * optimizer and label numbering work over all the code at once.
+ */
+
+// codeGen.h comes first since the program() of parser.h would
+// hide the VirtMach program type it uses.
+#include "codeGen.h"
+#include "pipeline.h"
+#include "parser.h"
+#include "scanner.h"
+#include "driver.h"
+#include "semantics.h"
+#include "simplify.h"
+#include "chunks.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <stdlib.h>
+#include <pthread.h>
+using namespace std;
+
+static bool pipeline = false;	// Compile with the pipeline
+static spscRing<ringToken, TOKEN_RING> tokens;	// Lexer to parser
+static spscRing<Node*, PIECE_RING> pieces;	// Parser to checking thread, NULL ends
+static int stopping = 0;	// Set at exit so waiting threads give up
+static bool running = false;	// Threads started and not yet joined
+static bool ownLexer = false;	// The lexer thread was started
+static pthread_t lexer;
+static pthread_t checker;
+static stringstream errors;	// Semantics errors, printed once parsing is done
+static bool passed = true;	// Semantics of every piece so far
+
+/* Turns on compiling with the pipeline.
+ */
+void setPipeline(bool on)
+{
+  pipeline = on;
+}
+
+/* True if the pipeline is used.
+ */
+bool getPipeline()
+{
+  return pipeline;
+}
+
+/* Parses the input set with setInput with the other two stages
+ * on their own threads. Returns the root of a tree ready for code
+ * generation, setting passedSemantics as checkSemantics would.
+ */
+Node* pipelineFront(bool &passedSemantics)
+{
+  if(getParallelLex() == 0)
+  {
+    setTokenSource(takeToken);
+    setNotice(pushNotice);
+  }
+  setParsedHook(handPiece);
+  setSemanticsOut(errors);
+
+  // Registered after every static is constructed, so it runs
+  // before they are destroyed if a stage exits the program.
+  atexit(stopPipeline);
+  running = true;
+  // Tokens lexed in parallel are ready already, see chunks.cpp.
+  ownLexer = getParallelLex() == 0;
+  if((ownLexer && pthread_create(&lexer, NULL, lexThread, NULL) != 0)
+     || pthread_create(&checker, NULL, checkThread, NULL) != 0)
+  {
+    cout << "Unable to start pipeline threads.\n";
+    exit(1);
+  }
+
+  Node* root = parser();
+  handPiece(NULL);
+  if(ownLexer)
+  {
+    pthread_join(lexer, NULL);
+    setTokenSource(NULL);
+  }
+  pthread_join(checker, NULL);
+  running = false;
+
+  setNotice(printNotice);
+  setParsedHook(NULL);
+  setSemanticsOut(cout);
+  cout << errors.str();
+  setSimplified(true);
+  passedSemantics = passed;
+  return root;
+}
+
+/* Thread body for the lexer. Builds tokens until the end of file.
+ */
+void *lexThread(void *)
+{
+  // The thread reads the file from its start, as setInput gave
+  // the file only to the main thread.
+  const char *begin;
+  const char *end;
+  getInputText(begin, end);
+  setInputText(begin, end);
+
+  ringToken item;
+  item.fatal = false;
+  do
+  {
+    item.tk = getToken();
+    if(!ringPush(tokens, item, stopping))
+    {
+      return NULL;
+    }
+  } while(item.tk.id != EOF_tk);
+  return NULL;
+}
+
+/* Thread body for checking semantics and simplifying each piece
+ * handed over by the parser, in order.
+ */
+void *checkThread(void *)
+{
+  Node* piece;
+  while(ringPop(pieces, piece, stopping) && piece)
+  {
+    passed = checkSemantics(piece);
+    simplifyTree(piece);
+  }
+  return NULL;
+}
+
+/* Sends a scanner message to the parser in place of printing it.
+ * After an error the lexer thread ends, as the driver expects
+ * nothing to return from one.
+ */
+void pushNotice(string text, bool fatal)
+{
+  ringToken item;
+  item.note = text;
+  item.fatal = fatal;
+  ringPush(tokens, item, stopping);
+  if(fatal)
+  {
+    pthread_exit(NULL);
+  }
+}
+
+/* Gives the parser the next token from the lexer thread, printing
+ * any scanner message before it.
+ */
+token takeToken()
+{
+  ringToken item;
+  while(ringPop(tokens, item, stopping))
+  {
+    if(item.note.empty())
+    {
+      return item.tk;
+    }
+    printNotice(item.note, item.fatal);
+  }
+  return item.tk;
+}
+
+/* Passes a finished piece from the parser to the checking thread.
+ * NULL tells it the parser is done.
+ */
+void handPiece(Node* piece)
+{
+  ringPush(pieces, piece, stopping);
+}
+
+/* Ends both threads when the program exits before the pipeline
+ * finished, as it does on a parse or scanner error.
+ */
+void stopPipeline()
+{
+  if(!running)
+  {
+    return;
+  }
+  __atomic_store_n(&stopping, 1, __ATOMIC_RELAXED);
+  if(ownLexer)
+  {
+    pthread_join(lexer, NULL);
+  }
+  pthread_join(checker, NULL);
+  running = false;
+}
@@ -0,0 +1,95 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for pipeline.cpp.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "node.h"
+#include "token.h"
+#include <string>
+#include <sched.h>
+
+// Tokens the lexer may get ahead of the parser, and finished
+// statements the parser may get ahead of the checking thread.
+static const unsigned int TOKEN_RING = 4096;
+static const unsigned int PIECE_RING = 1024;
+
+// One token, or a scanner message to print before the next one.
+struct ringToken
+{
+  token tk;
+  std::string note;	// Warning or error, empty for a token
+  bool fatal;		// The lexer stopped after this error
+};
+
+// Queue with one thread putting items in and one taking them out,
+// so neither needs a lock. Only the producer writes tail and only
+// the consumer writes head. They sit on separate cache lines, so
+// the two threads do not keep taking the line from each other.
+template <typename T, unsigned int SIZE>
+struct spscRing
+{
+  T slots[SIZE];
+  char pad1[64];
+  unsigned int head;	// Next slot to take
+  char pad2[64];
+  unsigned int tail;	// Next slot to fill
+  char pad3[64];
+};
+
+/* Waits for room, then adds an item. Gives up and returns false
+ * once stop is set, since the consumer may never take another.
+ */
+template <typename T, unsigned int SIZE>
+bool ringPush(spscRing<T, SIZE> &ring, const T &item, const int &stop)
+{
+  unsigned int tail = ring.tail;
+  while(tail - __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE) == SIZE)
+  {
+    if(__atomic_load_n(&stop, __ATOMIC_RELAXED))
+    {
+      return false;
+    }
+    sched_yield();
+  }
+  ring.slots[tail % SIZE] = item;
+  __atomic_store_n(&ring.tail, tail + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+/* Waits for an item, then takes it. Returns false once stop is
+ * set instead of waiting on a producer that has gone.
+ */
+template <typename T, unsigned int SIZE>
+bool ringPop(spscRing<T, SIZE> &ring, T &item, const int &stop)
+{
+  unsigned int head = ring.head;
+  while(__atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE) == head)
+  {
+    if(__atomic_load_n(&stop, __ATOMIC_RELAXED))
+    {
+      return false;
+    }
+    sched_yield();
+  }
+  item = ring.slots[head % SIZE];
+  __atomic_store_n(&ring.head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+void setPipeline(bool);
+bool getPipeline();
+Node* pipelineFront(bool &);
+
+void *lexThread(void *);
+void *checkThread(void *);
+void pushNotice(std::string, bool);
+token takeToken();
+void handPiece(Node*);
+void stopPipeline();
+
+#endif
@@ -0,0 +1,268 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Instrumented simulator for vmsim -p. Programs run the same way
+ * as in virtMach.cpp, but every instruction counts its executions.
+ * The counts are then added up per instruction, per label, and
+ * per source line and printed hottest first.
+ *
+ * Source lines come from the .map file written by comp --line-map,
+ * one line number per instruction. Each label gets the instructions
+ * from it up to the next label, so a loop body shows up under the
+ * label at its top.
+ */
+
+#include "profile.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+using namespace std;
+
+// Rows printed in each part of the report.
+static const unsigned int PROFILE_ROWS = 20;
+
+/* Reads the .map file for a program. Returns false, leaving the
+ * program as it was, if there is none or it does not match.
+ */
+bool loadLineMap(string filename, program &prog)
+{
+  ifstream mapFile(filename.c_str());
+  vector<int> lines;
+  int line;
+  while(mapFile >> line)
+  {
+    lines.push_back(line);
+  }
+  if(lines.size() != prog.code.size())
+  {
+    return false;
+  }
+  prog.lines.swap(lines);
+  return true;
+}
+
+/* Executes a loaded program like execProgram in virtMach.cpp,
+ * adding one to counts for every instruction executed. counts is
+ * resized to the program first.
+ */
+runResult profileProgram(const program &prog, istream *in, ostream &out, vector<long> &counts)
+{
+  vector<int> data = prog.data;
+  int acc = 0;
+  unsigned int pc = 0;
+  counts.assign(prog.code.size(), 0);
+
+  while(pc < prog.code.size())
+  {
+    const instr &cur = prog.code[pc];
+    int value = cur.immediate ? cur.arg : 0;
+    if(!cur.immediate && cur.op >= LOAD_op && cur.op <= DIV_op)
+    {
+      value = data[cur.arg];
+    }
+    counts[pc]++;
+    pc++;
+
+    switch(cur.op)
+    {
+    case READ_op:
+      if(!in || !(*in >> data[cur.arg]))
+      {
+        return INPUT_run;
+      }
+      break;
+    case WRITE_op:
+      out << (cur.immediate ? cur.arg : data[cur.arg]) << endl;
+      break;
+    case LOAD_op:
+      acc = value;
+      break;
+    case STORE_op:
+      data[cur.arg] = acc;
+      break;
+    case ADD_op:
+      acc += value;
+      break;
+    case SUB_op:
+      acc -= value;
+      break;
+    case MULT_op:
+      acc *= value;
+      break;
+    case DIV_op:
+      if(value == 0)
+      {
+        return DIVIDE_run;
+      }
+      acc /= value;
+      break;
+    case BR_op:
+      pc = cur.arg;
+      break;
+    case BRNEG_op:
+      pc = acc < 0 ? cur.arg : pc;
+      break;
+    case BRZNEG_op:
+      pc = acc <= 0 ? cur.arg : pc;
+      break;
+    case BRPOS_op:
+      pc = acc > 0 ? cur.arg : pc;
+      break;
+    case BRZPOS_op:
+      pc = acc >= 0 ? cur.arg : pc;
+      break;
+    case BRZERO_op:
+      pc = acc == 0 ? cur.arg : pc;
+      break;
+    case NOOP_op:
+      break;
+    case STOP_op:
+      return STOP_run;
+    }
+  }
+
+  return STOP_run;
+}
+
+/* Prints the hot spot report for the counts from profileProgram.
+ * Without a line map the source line part is left out.
+ */
+void printProfile(ostream &out, const program &prog, const vector<long> &counts, bool haveLines)
+{
+  // Name every label. Bytecode keeps no names, so branch targets
+  // get one from their index like vmconv gives them.
+  vector<string> labels(prog.code.size());
+  map<string, int>::const_iterator it = prog.labels.begin();
+  while(it != prog.labels.end())
+  {
+    labels[it->second] = it->first;
+    it++;
+  }
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    const instr &cur = prog.code[i];
+    if(cur.op >= BR_op && cur.op <= BRZERO_op && labels[cur.arg].empty())
+    {
+      stringstream name;
+      name << "L" << cur.arg;
+      labels[cur.arg] = name.str();
+    }
+  }
+
+  long total = 0;
+  vector<pair<long, string> > instrs;
+  vector<pair<long, string> > regions;
+  map<int, long> lines;
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    total += counts[i];
+    stringstream row;
+    row << setw(5) << i << "  " << left << setw(20) << instrText(prog, labels, i) << right;
+    if(haveLines && prog.lines[i] > 0)
+    {
+      row << "line " << prog.lines[i];
+    }
+    instrs.push_back(pair<long, string>(counts[i], row.str()));
+
+    if(i == 0 || !labels[i].empty())
+    {
+      regions.push_back(pair<long, string>(0, labels[i].empty() ? "(start)" : labels[i]));
+    }
+    regions.back().first += counts[i];
+    lines[prog.lines[i]] += counts[i];
+  }
+
+  out << "Profile: " << total << " instructions executed\n";
+  printHot(out, "Hot instructions:", instrs, total);
+  printHot(out, "Hot labels:", regions, total);
+  if(!haveLines)
+  {
+    out << "\nNo line map, compile with comp --line-map for source lines.\n";
+    return;
+  }
+  vector<pair<long, string> > sources;
+  map<int, long>::iterator line = lines.begin();
+  while(line != lines.end())
+  {
+    stringstream name;
+    if(line->first > 0)
+    {
+      name << "line " << line->first;
+    }
+    else
+    {
+      name << "(no line)";
+    }
+    sources.push_back(pair<long, string>(line->second, name.str()));
+    line++;
+  }
+  printHot(out, "Hot source lines:", sources, total);
+}
+
+/* Prints one part of the report, hottest rows first and rows
+ * that never ran left out. Ties keep their program order.
+ */
+void printHot(ostream &out, string title, vector<pair<long, string> > &rows, long total)
+{
+  vector<pair<long, string> > hot;
+  for(unsigned int i = 0; i < rows.size(); i++)
+  {
+    if(rows[i].first > 0)
+    {
+      // Negated so the default order puts the hottest first.
+      hot.push_back(pair<long, string>(-rows[i].first, rows[i].second));
+    }
+  }
+  stable_sort(hot.begin(), hot.end(), hotter);
+
+  out << endl << title << endl;
+  for(unsigned int i = 0; i < hot.size() && i < PROFILE_ROWS; i++)
+  {
+    long count = -hot[i].first;
+    out << setw(12) << count << "  " << fixed << setprecision(1) << setw(5)
+        << 100.0 * count / total << "%  " << hot[i].second << endl;
+  }
+  if(hot.size() > PROFILE_ROWS)
+  {
+    out << "  ... " << hot.size() - PROFILE_ROWS << " more\n";
+  }
+}
+
+/* Orders report rows by count only, for stable_sort.
+ */
+bool hotter(const pair<long, string> &a, const pair<long, string> &b)
+{
+  return a.first < b.first;
+}
+
+/* Gives an instruction as written in .asm, with its label.
+ */
+string instrText(const program &prog, const vector<string> &labels, int index)
+{
+  const instr &cur = prog.code[index];
+  stringstream text;
+  if(!labels[index].empty())
+  {
+    text << labels[index] << ": ";
+  }
+  text << opName(cur.op);
+  if(cur.op >= BR_op && cur.op <= BRZERO_op)
+  {
+    text << " " << labels[cur.arg];
+  }
+  else if(cur.immediate)
+  {
+    text << " " << cur.arg;
+  }
+  else if(cur.op != NOOP_op && cur.op != STOP_op)
+  {
+    text << " " << prog.names[cur.arg];
+  }
+  return text.str();
+}
@@ -0,0 +1,26 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for profile.cpp.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "virtMach.h"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+bool loadLineMap(std::string, program &);
+runResult profileProgram(const program &, std::istream *, std::ostream &,
+                         std::vector<long> &);
+void printProfile(std::ostream &, const program &, const std::vector<long> &, bool);
+void printHot(std::ostream &, std::string, std::vector<std::pair<long, std::string> > &,
+              long);
+bool hotter(const std::pair<long, std::string> &, const std::pair<long, std::string> &);
+std::string instrText(const program &, const std::vector<std::string> &, int);
+
+#endif
@@ -0,0 +1,244 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Runs a compiled program against every file in a directory for
+ * comp --run-batch, using a pool of worker threads.
+ *
+ * Inputs are split into one contiguous range per worker. A worker
+ * runs its range from the front, and once it is empty it steals the
+ * back half of the range of another worker that still has inputs
+ * left. Each range has its own lock, taken only by its owner and the
+ * occasional thief, so there is no lock every worker waits on.
+ *
+ * Outputs go into a slot per input, marked ready once complete. The
+ * main thread writes slots in input order as they become ready, so
+ * output is the same for any number of workers. Every run starts
+ * from its own copy of the initial values from writeFinal, so runs
+ * never share variables.
+ */
+
+#include "runner.h"
+#include "codeGen.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <dirent.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+static bool runBatch = false;	// Run the program after compiling it
+static string inputDir = "";	// Directory of input files
+static int jobs = 0;		// Worker threads, 0 for one per processor
+
+/* Turns on running the compiled program against an input directory.
+ */
+void setRunBatch(bool run)
+{
+  runBatch = run;
+}
+
+/* True if the compiled program is to be run against inputs.
+ */
+bool getRunBatch()
+{
+  return runBatch;
+}
+
+/* Sets the directory holding one input file per run.
+ */
+void setInputDir(string dir)
+{
+  inputDir = dir;
+}
+
+/* Sets the number of worker threads.
+ */
+void setJobs(int count)
+{
+  jobs = count;
+}
+
+/* Runs the program just compiled against every input file, writing
+ * each output after a line naming its input, in file name order.
+ */
+void runInputs(ostream &out)
+{
+  program prog;
+  finalProgram(prog);
+  runnerState state;
+  state.prog = &prog;
+  findInputs(inputDir, state.inputs);
+  int count = state.inputs.size();
+  state.outputs.resize(count);
+  state.ready.assign(count, 0);
+
+  int workers = jobs > 0 ? jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  workers = max(1, min(workers, count));
+  state.queues.resize(workers);
+  for(int i = 0; i < workers; i++)
+  {
+    pthread_mutex_init(&state.queues[i].lock, NULL);
+    state.queues[i].front = (long)count * i / workers;
+    state.queues[i].back = (long)count * (i + 1) / workers;
+  }
+
+  vector<pthread_t> threads(workers);
+  vector<workerArgs> args(workers);
+  for(int i = 0; i < workers; i++)
+  {
+    args[i].state = &state;
+    args[i].id = i;
+    if(pthread_create(&threads[i], NULL, runWorker, &args[i]) != 0)
+    {
+      cout << "Unable to start worker threads.\n";
+      exit(1);
+    }
+  }
+
+  for(int i = 0; i < count; i++)
+  {
+    while(!__atomic_load_n(&state.ready[i], __ATOMIC_ACQUIRE))
+    {
+      sched_yield();
+    }
+    out << "==> " << state.inputs[i] << " <==\n" << state.outputs[i];
+    string().swap(state.outputs[i]);
+  }
+  out.flush();
+
+  for(int i = 0; i < workers; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  for(int i = 0; i < workers; i++)
+  {
+    pthread_mutex_destroy(&state.queues[i].lock);
+  }
+}
+
+/* Lists the regular files in a directory, sorted by name.
+ * Hidden files are left out.
+ */
+void findInputs(string dir, vector<string> &inputs)
+{
+  DIR *entries = opendir(dir.c_str());
+  if(!entries)
+  {
+    cout << "Unable to open input directory " << dir << endl;
+    exit(1);
+  }
+  if(dir[dir.length() - 1] != '/')
+  {
+    dir += '/';
+  }
+  dirent *entry;
+  while((entry = readdir(entries)) != NULL)
+  {
+    string path = dir + entry->d_name;
+    struct stat info;
+    if(entry->d_name[0] != '.' && stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+    {
+      inputs.push_back(path);
+    }
+  }
+  closedir(entries);
+  sort(inputs.begin(), inputs.end());
+}
+
+/* Thread body for one worker. Runs inputs from its own range, then
+ * from stolen ones, until no worker has any left.
+ */
+void *runWorker(void *arg)
+{
+  workerArgs *args = static_cast<workerArgs *>(arg);
+  runnerState &state = *args->state;
+  workQueue &own = state.queues[args->id];
+
+  while(true)
+  {
+    int input;
+    if(!takeWork(own, input))
+    {
+      if(!stealWork(state, args->id))
+      {
+        return NULL;
+      }
+      continue;
+    }
+    state.outputs[input] = runInput(*state.prog, state.inputs[input]);
+    __atomic_store_n(&state.ready[input], 1, __ATOMIC_RELEASE);
+  }
+}
+
+/* Takes the next input from the front of a worker's own range.
+ */
+bool takeWork(workQueue &queue, int &input)
+{
+  pthread_mutex_lock(&queue.lock);
+  bool found = queue.front < queue.back;
+  if(found)
+  {
+    input = queue.front++;
+  }
+  pthread_mutex_unlock(&queue.lock);
+  return found;
+}
+
+/* Moves the back half of another worker's range into the empty
+ * range of worker id. Returns false once every range is empty.
+ * Ranges only shrink, so an empty pass means all work is taken.
+ */
+bool stealWork(runnerState &state, int id)
+{
+  int workers = state.queues.size();
+  for(int i = 1; i < workers; i++)
+  {
+    workQueue &victim = state.queues[(id + i) % workers];
+    pthread_mutex_lock(&victim.lock);
+    int left = victim.back - victim.front;
+    int split = victim.back - (left + 1) / 2;
+    if(left > 0)
+    {
+      victim.back = split;
+    }
+    pthread_mutex_unlock(&victim.lock);
+
+    if(left > 0)
+    {
+      workQueue &own = state.queues[id];
+      pthread_mutex_lock(&own.lock);
+      own.front = split;
+      own.back = split + (left + 1) / 2;
+      pthread_mutex_unlock(&own.lock);
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Runs the program with one input file and gives everything it
+ * wrote, ending with the same error vmsim would give if it failed.
+ */
+string runInput(const program &prog, string filename)
+{
+  ifstream in(filename.c_str());
+  stringstream out;
+  long count;
+  runResult result = execProgram(prog, in.is_open() ? &in : NULL, out, -1, count);
+  if(result == INPUT_run)
+  {
+    out << "\nVM ERROR: Unable to read input for 'READ'.\n\n";
+  }
+  else if(result == DIVIDE_run)
+  {
+    out << "\nVM ERROR: Division by zero 'DIV'.\n\n";
+  }
+  return out.str();
+}
@@ -0,0 +1,53 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for runner.cpp.
+ */
+
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include "virtMach.h"
+#include <ostream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+// Inputs a worker still has to run, from front up to back. The
+// owner takes from the front and thieves take from the back.
+struct workQueue
+{
+  pthread_mutex_t lock;
+  int front;
+  int back;
+};
+
+struct runnerState
+{
+  const program *prog;
+  std::vector<std::string> inputs;	// Input files in the order output is written
+  std::vector<std::string> outputs;	// Output of each input once it has run
+  std::vector<int> ready;		// Set when the output of an input is complete
+  std::vector<workQueue> queues;	// One per worker
+};
+
+struct workerArgs
+{
+  runnerState *state;
+  int id;
+};
+
+void setRunBatch(bool);
+bool getRunBatch();
+void setInputDir(std::string);
+void setJobs(int);
+void runInputs(std::ostream &);
+
+void findInputs(std::string, std::vector<std::string> &);
+void *runWorker(void *);
+bool takeWork(workQueue &, int &);
+bool stealWork(runnerState &, int);
+std::string runInput(const program &, std::string);
+
+#endif
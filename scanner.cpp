@@ -6,6 +6,12 @@
  * Given a file pointer, will provide a single character
  * or peek at the next character without consuming it.
  *
+ * The whole input is read into memory up front. Tokens only keep
+ * how far into the input they were built, and the offset of every
+ * newline is found once with memchr, so a line or column is looked
+ * up with a binary search when an error or remark prints one. The
+ * driver does no counting of its own for each character.
+ *
  * Intended to work with driver.cpp. The driver will
  * ask for characters to provide the actual token in return.
  */
@@ -15,25 +21,108 @@
 #include "scanner.h"
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 using namespace std;
 
-// Stores a single file pointer for character retrieval
-// without having to reset it on each call.
-static FILE *input = NULL;
+// Stores the whole input file.
+static string fileText;
+// Offset of every newline and carriage return in the file, in order.
+// Both end a line, as they do in filterInput.
+static vector<int> newlines;
+// Characters the calling thread reads, the whole file or the part
+// of it the thread lexes. setInput gives the calling thread the file.
+static __thread const char *text = NULL;
+static __thread const char *textEnd = NULL;
+// Gives tokens built elsewhere instead of calling the driver, set
+// when the driver runs on a thread of its own. Threads parsing
+// ahead each take tokens from their own place, see blocks.cpp.
+static __thread token (*source)() = NULL;
 
-/* Sets static file pointer for two functions below
+/* Reads the whole file into memory for the functions below,
+ * and finds where every line starts.
  */
 void setInput(FILE *file)
 {
-  input = file;
-  if(input == NULL)
+  if(file == NULL)
   {
     cout << "Error: input file does not exist or cannot be opened.\n";
     cout << "Usage: scanner [file]\n";
     exit(1);
   }
+  fileText.clear();
+  char buffer[65536];
+  size_t got;
+  while((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    fileText.append(buffer, got);
+  }
+  setInputText(fileText.data(), fileText.data() + fileText.length());
+  indexLines();
+}
+
+/* Gives the text of the whole file, for lexing it on other threads.
+ */
+void getInputText(const char *&begin, const char *&end)
+{
+  begin = fileText.data();
+  end = begin + fileText.length();
+}
+
+/* Finds the offset of every newline in the file. memchr goes
+ * through many characters at a time, and carriage returns are only
+ * looked for apart if the file has any.
+ */
+void indexLines()
+{
+  const char *begin = fileText.data();
+  const char *end = begin + fileText.length();
+  newlines.clear();
+  findNewlines(begin, end, '\n', newlines);
+  if(memchr(begin, '\r', end - begin))
+  {
+    size_t split = newlines.size();
+    findNewlines(begin, end, '\r', newlines);
+    inplace_merge(newlines.begin(), newlines.begin() + split, newlines.end());
+  }
+}
+
+/* Adds the offset of every c from begin to end to found, in order.
+ */
+void findNewlines(const char *begin, const char *end, char c, vector<int> &found)
+{
+  const char *at = begin;
+  while((at = static_cast<const char *>(memchr(at, c, end - at))) != NULL)
+  {
+    found.push_back(at - begin);
+    at++;
+  }
+}
+
+/* Characters of the input read so far by the calling thread.
+ */
+int inputOffset()
+{
+  return text - fileText.data();
+}
+
+/* Line of the character at offset, counting every newline before it.
+ */
+int lineAt(int offset)
+{
+  return lower_bound(newlines.begin(), newlines.end(), offset) - newlines.begin() + 1;
+}
+
+/* Column of the character at offset, 1 for the first of a line.
+ */
+int columnAt(int offset)
+{
+  vector<int>::iterator next = lower_bound(newlines.begin(), newlines.end(), offset);
+  int start = next == newlines.begin() ? 0 : *(next - 1) + 1;
+  return offset - start + 1;
 }
 
 /* Directs driver to create and return a token, then
@@ -41,37 +130,39 @@ void setInput(FILE *file)
  */
 token scanToken()
 {
-  token nToken = getToken();
+  token nToken = source ? source() : getToken();
   return nToken;
 }
 
+/* Sets a function scanToken takes tokens from on the calling
+ * thread, or NULL to build them with the driver again.
+ */
+void setTokenSource(token (*next)())
+{
+  source = next;
+}
+
+/* Reads characters from begin up to end on the calling thread.
+ */
+void setInputText(const char *begin, const char *end)
+{
+  text = begin;
+  textEnd = end;
+}
+
 /* Retrieves and consumes the next character from
  * the input file/file pointer. Returns a negative
  * value on EOF to easily check for the end of file.
  */
 int getChar()
 {
-  int c = fgetc(input);
-
-  if(feof(input))
-  {
-    c = -1;
-  }
-
-  return c;
+  return text < textEnd ? static_cast<unsigned char>(*text++) : -1;
 }
 
 /* Retrieves the next character from input file/file
  * pointer without consuming.
- * Stores the file pointer location before retrieving
- * the character so it is immediately sent back to the
- * character it just consumed.
  */
 int lookupChar()
 {
-  fpos_t pos;
-  fgetpos(input, &pos);
-  int c = fgetc(input);
-  fsetpos(input, &pos);
-  return c;
+  return text < textEnd ? static_cast<unsigned char>(*text) : -1;
 }
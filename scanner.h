@@ -12,9 +12,18 @@
 
 #include <stdio.h>
 #include "token.h"
+#include <vector>
 
 void setInput(FILE *);
+void getInputText(const char *&, const char *&);
+void indexLines();
+void findNewlines(const char *, const char *, char, std::vector<int> &);
+int inputOffset();
+int lineAt(int);
+int columnAt(int);
 token scanToken();
+void setTokenSource(token (*)());
+void setInputText(const char *, const char *);
 int getChar();
 int lookupChar();
 
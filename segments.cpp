@@ -0,0 +1,178 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Generates code for the statements of the outer block at once for
+ * comp --parallel-gen. The output is the same as generating them in
+ * order.
+ *
+ * Temporary variables already start over with every statement, so
+ * statements only share three things: label numbers, the numbers of
+ * saved values, and the values saved for reuse, see codeGen.cpp.
+ * Saved values are forgotten at every label, so a statement that ends
+ * by setting a label, or starts with a label statement, begins with
+ * nothing saved, just as the first statement of a program does. The
+ * statements are split into segments at those points, and each
+ * segment is generated on its own with nothing carried over.
+ *
+ * Before any code is generated, a pass over the tree counts the
+ * labels each segment will use, making the same choices code
+ * generation makes, and reserves a range of label numbers for each.
+ * Saved values are numbered from #0 in each segment and moved past
+ * the ones before it when the segments are joined in order, before
+ * nameSaved gives them their real names. Should any segment use a
+ * different number of labels than reserved, the whole program is
+ * generated again in order instead.
+ */
+
+#include "segments.h"
+#include "codeGen.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+using namespace std;
+
+static int parallelGen = 0;	// Threads, -1 for one per processor, 0 for off
+static vector<genSegment> segments;	// Outer block statements, split
+static unsigned int nextSegment = 0;	// Next segment for a worker to take
+
+/* Turns on generating code in parallel with a number of threads,
+ * -1 for one per processor, or 0 to turn it off.
+ */
+void setParallelGen(int threads)
+{
+  parallelGen = threads;
+}
+
+/* Number of threads asked for, 0 if generating in parallel is off.
+ */
+int getParallelGen()
+{
+  return parallelGen;
+}
+
+/* Generates the code of a whole tree the same as recGen, with the
+ * segments of the outer block on worker threads.
+ */
+void genParallel(Node* root)
+{
+  vector<Node*> vars;
+  vector<Node*> stats;
+  if(!outerParts(root, vars, stats))
+  {
+    recGen(root);
+    return;
+  }
+
+  segments.clear();
+  int labels = 0;
+  for(unsigned int i = 0; i < stats.size(); i++)
+  {
+    if(i == 0 || endsClear(stats[i - 1]) || stats[i]->child1->label.compare("label") == 0)
+    {
+      genSegment segment;
+      segment.firstLabel = labels;
+      segment.labels = 0;
+      segments.push_back(segment);
+    }
+    int count = countLabels(stats[i]);
+    segments.back().stats.push_back(stats[i]);
+    segments.back().labels += count;
+    labels += count;
+  }
+
+  int threads = parallelGen;
+  if(threads < 0)
+  {
+    long most = stats.size() / MIN_GEN + 1;
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    threads = max(1, (int)min((long)threads, most));
+  }
+  threads = min(threads, (int)segments.size());
+  nextSegment = 0;
+  vector<pthread_t> workers(threads);
+  for(int i = 0; i < threads; i++)
+  {
+    if(pthread_create(&workers[i], NULL, genThread, NULL) != 0)
+    {
+      cout << "Unable to start code generation threads.\n";
+      exit(1);
+    }
+  }
+  for(int i = 0; i < threads; i++)
+  {
+    pthread_join(workers[i], NULL);
+  }
+
+  for(unsigned int i = 0; i < segments.size(); i++)
+  {
+    if(segments[i].used != segments[i].labels)
+    {
+      segments.clear();
+      recGen(root);
+      return;
+    }
+  }
+  for(unsigned int i = 0; i < vars.size(); i++)
+  {
+    recGen(vars[i]);
+  }
+  for(unsigned int i = 0; i < segments.size(); i++)
+  {
+    joinSegment(segments[i]);
+  }
+  segments.clear();
+}
+
+/* Finds the declarations of the program and of its outer block,
+ * and every <stat> of the outer block in order. False if the tree
+ * is not shaped as the parser builds it.
+ */
+bool outerParts(Node* root, vector<Node*> &vars, vector<Node*> &stats)
+{
+  if(!root || root->label.compare("program") != 0)
+  {
+    return false;
+  }
+  // vars may be empty, moving what follows up a child.
+  Node* block = root->child2 ? root->child2 : root->child1;
+  if(root->child2)
+  {
+    vars.push_back(root->child1);
+  }
+  if(!block || block->label.compare("block") != 0)
+  {
+    return false;
+  }
+  Node* list = block->child2 ? block->child2 : block->child1;
+  if(block->child2)
+  {
+    vars.push_back(block->child1);
+  }
+
+  for(; list; list = list->child2)
+  {
+    if(!list->child1 || list->child1->label.compare("stat") != 0 || !list->child1->child1)
+    {
+      return false;
+    }
+    stats.push_back(list->child1);
+  }
+  return !stats.empty();
+}
+
+/* Thread body for a worker. Takes segments in turn and generates
+ * each into its own buffer.
+ */
+void *genThread(void *)
+{
+  unsigned int i;
+  while((i = __atomic_fetch_add(&nextSegment, 1, __ATOMIC_RELAXED)) < segments.size())
+  {
+    genSegmentCode(segments[i]);
+  }
+  return NULL;
+}
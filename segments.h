@@ -0,0 +1,23 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for segments.cpp.
+ */
+
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include "node.h"
+#include <vector>
+
+// Fewest statements worth a thread when the count is left to segments.cpp.
+static const unsigned int MIN_GEN = 256;
+
+void setParallelGen(int);
+int getParallelGen();
+void genParallel(Node*);
+bool outerParts(Node*, std::vector<Node*> &, std::vector<Node*> &);
+void *genThread(void *);
+
+#endif
@@ -12,13 +12,15 @@
 
 #include "node.h"
 #include "semantics.h"
+#include "scanner.h"
 #include <string>
 #include <iostream>
 #include <map>
 using namespace std;
 
-static map<string, int> symbols;	// Store variable strings and line numbers
+static map<string, int> symbols;	// Store variable strings and input offsets
 static bool passedSemantics = true;	// Sets to false on any error and returns
+static ostream *report = &cout;		// Where errors are printed
 
 /****************
  * Auxiliary function. Pass the root node of a tree
@@ -31,6 +33,15 @@ bool checkSemantics(Node* root)
   return passedSemantics;
 }
 
+/****************
+ * Sends error messages somewhere other than cout, so pipeline.cpp
+ * can hold them until the parser is done.
+ */
+void setSemanticsOut(ostream &out)
+{
+  report = &out;
+}
+
 /****************
  * Recursively traverses tree as a preorder traversal.
  * Skips over null pointers, and checks each node only
@@ -113,7 +124,7 @@ void checkNode(Node* node)
 }
 
 /*****************
- * Add a declared variable to the map structure with a line number.
+ * Add a declared variable to the map structure with its offset.
  * If the variable is already declared, skip and return false for
  * an error.
  */
@@ -122,11 +133,10 @@ bool insertIdent(Node* node)
   string tok = node->token1.tokenString;
   if(symbols.find(tok) == symbols.end())
   {
-    // Variable names act as a key, line numbers a value.
+    // Variable names act as a key, offsets a value.
     // This allows printing the line number of the original
     // declaration.
-    int line = node->token1.lineNum;
-    symbols.insert(pair<string, int>(tok, line));
+    symbols.insert(pair<string, int>(tok, node->token1.offset));
     return true;
   }
   else
@@ -163,10 +173,10 @@ void declareError(Node* node)
 {
   passedSemantics = false;
   string tok = node->token1.tokenString;
-  int line = node->token1.lineNum;
-  int origLine = symbols.find(tok)->second;
-  cout << "SEMANTICS ERROR: Identifier '" << tok << "' on line " << line << " was already declared.\n";
-  cout << "  Original declaration of '" << tok << "' occurs on line " << origLine << ".\n";
+  int line = lineAt(node->token1.offset);
+  int origLine = lineAt(symbols.find(tok)->second);
+  *report << "SEMANTICS ERROR: Identifier '" << tok << "' on line " << line << " was already declared.\n";
+  *report << "  Original declaration of '" << tok << "' occurs on line " << origLine << ".\n";
 }
 
 /**************
@@ -178,6 +188,6 @@ void statError(Node* node)
 {
   passedSemantics = false;
   string tok = node->token1.tokenString;
-  int line = node->token1.lineNum;
-  cout << "SEMANTICS ERROR: Identifier '" << tok << "' on line " << line << " has not been delcared.\n";
+  int line = lineAt(node->token1.offset);
+  *report << "SEMANTICS ERROR: Identifier '" << tok << "' on line " << line << " has not been delcared.\n";
 }
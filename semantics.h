@@ -10,8 +10,10 @@
 #define SEMANTICS_H
 
 #include "node.h"
+#include <ostream>
 
 bool checkSemantics(Node*);
+void setSemanticsOut(std::ostream &);
 void checkSemanticsNode(Node*);
 void checkNode(Node*);
 bool insertIdent(Node*);
@@ -0,0 +1,360 @@
+/*******************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Algebraic simplification of expressions before code generation.
+ *
+ * Every <expr> in a statement is rebuilt bottom up. Nodes that only
+ * pass their single child along, including parentheses, are skipped
+ * since the shape of the tree already gives the order of operations.
+ * Operators whose sides are integers are computed here, and
+ * simple identities are removed:
+ * 	**x = x		x + 0 = x	x - 0 = x	0 - x = *x
+ * 	x * 1 = x	x / 1 = x	x * -1 = *x	x * 0 = 0
+ * 	x - *y = x + y	x + *y = x - y	*x + y = y - x	*(x - y) = y - x
+ * 	*x * *y = x * y	*x / *y = x / y
+ * Integers are moved to the right of + and * so code generation
+ * can use them directly as an argument.
+ *
+ * Anything that could divide by zero is never removed or computed
+ * here, so programs that fail at run time still fail the same way.
+ * Results wrap around like they would in VirtMach.
+ */
+
+#include "simplify.h"
+#include "node.h"
+#include "token.h"
+#include <string>
+#include <sstream>
+#include <climits>
+#include <stdlib.h>
+using namespace std;
+
+/****************
+ * Auxiliary function. Pass the root node of a tree and every
+ * expression in a statement is replaced by its simplified form.
+ * <RO> is the only child of <iffy> and <loop> that is not an
+ * expression or statement.
+ */
+void simplifyTree(Node* node)
+{
+  if(!node)
+  {
+    return;
+  }
+
+  if(node->label.compare("out") == 0 || node->label.compare("assign") == 0)
+  {
+    node->child1 = simplify(node->child1);
+  }
+  else if(node->label.compare("iffy") == 0 || node->label.compare("loop") == 0)
+  {
+    node->child1 = simplify(node->child1);
+    node->child3 = simplify(node->child3);
+    simplifyTree(node->child4);
+  }
+  else
+  {
+    simplifyTree(node->child1);
+    simplifyTree(node->child2);
+    simplifyTree(node->child3);
+    simplifyTree(node->child4);
+  }
+}
+
+/****************
+ * Returns the simplified form of an expression node. Children are
+ * simplified first, so rules only need to look one level down.
+ */
+Node* simplify(Node* node)
+{
+  switch(getType(node))
+  {
+  case LEAF_ex:
+    return node;
+  case PASS_ex:
+    return simplify(node->child1);
+  case NEG_ex:
+    return simplifyNeg(node, simplify(node->child1));
+  default:
+    return simplifyBinary(node, simplify(node->child1), simplify(node->child2));
+  }
+}
+
+/****************
+ * Negation of an already simplified value.
+ */
+Node* simplifyNeg(Node* node, Node* value)
+{
+  int num;
+  exprType type = getType(value);
+
+  // *c = -c, skipping the one integer that has no negative
+  if(getConst(value, num) && num != INT_MIN)
+  {
+    return makeNum(-num, node);
+  }
+  // **x = x
+  if(type == NEG_ex)
+  {
+    return value->child1;
+  }
+  // *(x - y) = y - x
+  if(type == SUB_ex)
+  {
+    return simplifyBinary(makeOp(SUB_ex, NULL, NULL, node), value->child2, value->child1);
+  }
+  node->child1 = value;
+  return node;
+}
+
+/****************
+ * A binary operator with both sides already simplified.
+ * node is reused when nothing better is found.
+ */
+Node* simplifyBinary(Node* node, Node* left, Node* right)
+{
+  exprType type = getType(node);
+  exprType leftType = getType(left);
+  exprType rightType = getType(right);
+  int leftNum = 0;
+  int rightNum = 0;
+  bool leftConst = getConst(left, leftNum);
+  bool rightConst = getConst(right, rightNum);
+
+  // Both sides are integers, compute it now.
+  int result;
+  if(leftConst && rightConst && canFold(type, leftNum, rightNum, result))
+  {
+    return makeNum(result, node);
+  }
+
+  // Keep integers on the right of operators that commute.
+  if((type == ADD_ex || type == MULT_ex) && leftConst && !rightConst)
+  {
+    return simplifyBinary(node, right, left);
+  }
+
+  switch(type)
+  {
+  case ADD_ex:
+    if(rightConst && rightNum == 0)
+    {
+      return left;
+    }
+    if(rightType == NEG_ex)
+    {
+      return simplifyBinary(makeOp(SUB_ex, NULL, NULL, node), left, right->child1);
+    }
+    if(leftType == NEG_ex)
+    {
+      return simplifyBinary(makeOp(SUB_ex, NULL, NULL, node), right, left->child1);
+    }
+    break;
+
+  case SUB_ex:
+    if(rightConst && rightNum == 0)
+    {
+      return left;
+    }
+    if(leftConst && leftNum == 0)
+    {
+      return simplifyNeg(makeOp(NEG_ex, NULL, NULL, node), right);
+    }
+    if(rightType == NEG_ex)
+    {
+      return simplifyBinary(makeOp(ADD_ex, NULL, NULL, node), left, right->child1);
+    }
+    break;
+
+  case MULT_ex:
+    if(rightConst && rightNum == 1)
+    {
+      return left;
+    }
+    if(rightConst && rightNum == -1)
+    {
+      return simplifyNeg(makeOp(NEG_ex, NULL, NULL, node), left);
+    }
+    // Anything with a division is still computed in case it divides by zero.
+    if(rightConst && rightNum == 0 && !hasDivide(left))
+    {
+      return right;
+    }
+    if(leftType == NEG_ex && rightType == NEG_ex)
+    {
+      return simplifyBinary(node, left->child1, right->child1);
+    }
+    break;
+
+  case DIV_ex:
+    if(rightConst && rightNum == 1)
+    {
+      return left;
+    }
+    if(rightConst && rightNum == -1)
+    {
+      return simplifyNeg(makeOp(NEG_ex, NULL, NULL, node), left);
+    }
+    if(leftType == NEG_ex && rightType == NEG_ex)
+    {
+      return simplifyBinary(node, left->child1, right->child1);
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  node->child1 = left;
+  node->child2 = right;
+  return node;
+}
+
+/****************
+ * Finds what an expression node computes from its label and tokens.
+ * <R> holds a variable or integer, or parentheses around <expr>.
+ * Every other label without an operator passes its child along.
+ */
+exprType getType(Node* node)
+{
+  if(node->label.compare("R") == 0)
+  {
+    return node->child1 ? PASS_ex : LEAF_ex;
+  }
+  string op = node->token1.tokenString;
+  if(op.empty())
+  {
+    return PASS_ex;
+  }
+  if(node->label.compare("M") == 0)
+  {
+    return NEG_ex;
+  }
+  if(node->label.compare("expr") == 0)
+  {
+    return SUB_ex;
+  }
+  if(node->label.compare("A") == 0)
+  {
+    return ADD_ex;
+  }
+  return op.compare("/") == 0 ? DIV_ex : MULT_ex;
+}
+
+/****************
+ * True if a node is an integer, setting num to its value.
+ */
+bool getConst(Node* node, int &num)
+{
+  if(getType(node) != LEAF_ex || node->token1.id != NUM_tk)
+  {
+    return false;
+  }
+  num = atoi(node->token1.tokenString.c_str());
+  return true;
+}
+
+/****************
+ * Computes left op right the way VirtMach would. Returns false for
+ * division by zero and the one division that overflows.
+ */
+bool canFold(exprType type, int left, int right, int &result)
+{
+  // Unsigned math wraps around without undefined behavior.
+  unsigned int a = left;
+  unsigned int b = right;
+  switch(type)
+  {
+  case ADD_ex:
+    result = a + b;
+    return true;
+  case SUB_ex:
+    result = a - b;
+    return true;
+  case MULT_ex:
+    result = a * b;
+    return true;
+  case DIV_ex:
+    if(right == 0 || (left == INT_MIN && right == -1))
+    {
+      return false;
+    }
+    result = left / right;
+    return true;
+  default:
+    return false;
+  }
+}
+
+/****************
+ * Creates an <R> holding an integer. The offset, and so the line,
+ * is taken from the node it replaces.
+ */
+Node* makeNum(int num, Node* from)
+{
+  stringstream value;
+  value << num;
+  Node* node = getNode("R");
+  node->token1.id = NUM_tk;
+  node->token1.tokenString = value.str();
+  node->token1.offset = from->token1.offset;
+  return node;
+}
+
+/****************
+ * Creates an operator node with the label and token the parser
+ * would have used for it.
+ */
+Node* makeOp(exprType type, Node* left, Node* right, Node* from)
+{
+  string label = "N";
+  string op = "*";
+  tokenID id = TIMES_tk;
+  switch(type)
+  {
+  case NEG_ex:
+    label = "M";
+    break;
+  case ADD_ex:
+    label = "A";
+    op = "+";
+    id = PLUS_tk;
+    break;
+  case SUB_ex:
+    label = "expr";
+    op = "-";
+    id = MINUS_tk;
+    break;
+  case DIV_ex:
+    op = "/";
+    id = DIVIDE_tk;
+    break;
+  default:
+    break;
+  }
+
+  Node* node = getNode(label);
+  node->token1.id = id;
+  node->token1.tokenString = op;
+  node->token1.offset = from->token1.offset;
+  node->child1 = left;
+  node->child2 = right;
+  return node;
+}
+
+/****************
+ * True if an expression divides anywhere.
+ */
+bool hasDivide(Node* node)
+{
+  if(!node)
+  {
+    return false;
+  }
+  if(getType(node) == DIV_ex)
+  {
+    return true;
+  }
+  return hasDivide(node->child1) || hasDivide(node->child2);
+}
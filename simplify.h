@@ -0,0 +1,31 @@
+/***********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Declares functions needed for simplify.cpp.
+ * Includes node.h to allow for Node and Node pointers.
+ */
+
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include "node.h"
+#include <string>
+
+// Kind of value an expression node computes, ignoring
+// which grammar level it came from.
+typedef enum {LEAF_ex, PASS_ex, NEG_ex, ADD_ex, SUB_ex, MULT_ex, DIV_ex} exprType;
+
+void simplifyTree(Node*);
+Node* simplify(Node*);
+Node* simplifyNeg(Node*, Node*);
+Node* simplifyBinary(Node*, Node*, Node*);
+
+exprType getType(Node*);
+bool getConst(Node*, int &);
+bool canFold(exprType, int, int, int &);
+Node* makeNum(int, Node*);
+Node* makeOp(exprType, Node*, Node*, Node*);
+bool hasDivide(Node*);
+
+#endif
@@ -25,7 +25,7 @@ struct token
 {
   tokenID id;		   // Id has associated strings to identify in testScanner.cpp
   std::string tokenString; // String from file that formed the token
-  int lineNum;		   // Line number of string from input file
+  int offset;		   // Characters of the input read when it was built, see lineAt
 };
 
 #endif
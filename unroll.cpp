@@ -0,0 +1,520 @@
+/*******************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Loop unrolling for loops whose number of iterations is known
+ * at compile time.
+ *
+ * A loop qualifies when its condition compares a variable v with
+ * an integer, or with a variable the loop never writes, and the
+ * body steps v exactly once per iteration with a statement
+ * 	v := v + c	or	v := v - c
+ * directly in the body. Nothing else in the body may write v.
+ *
+ * The value of v before the loop comes from a pass over the tree
+ * that follows which variables hold a known integer, starting
+ * from their declared values. Values only known on some paths
+ * are dropped where paths meet, after an iffy or at the top of
+ * a loop, and everything is dropped at a label since a goto
+ * could arrive from anywhere. READ always gives an unknown value.
+ *
+ * Given the iterations, a loop is fully unrolled when every copy
+ * of the body fits in the size budget. Otherwise the body is
+ * repeated up to the unroll factor inside the loop, with the
+ * iterations left over run once before it. Size counts the tokens
+ * kept in the tree, which is roughly one instruction each.
+ * Loops with a label inside are left alone, copying the body
+ * would declare the label more than once.
+ */
+
+#include "unroll.h"
+#include "codeGen.h"
+#include "simplify.h"
+#include "token.h"
+#include "scanner.h"
+#include <string>
+#include <sstream>
+#include <vector>
+#include <map>
+using namespace std;
+
+static int unrollBudget = 128;	// Largest size a loop may grow to, 0 for off
+static int unrollFactor = 4;	// Most copies of a body in one loop
+// Counting iterations stops here, loops running longer are left alone.
+static const int MAX_TRIPS = 1000000;
+
+static map<Node*, map<string, int> > entries;	// Known values before each loop
+static map<Node*, unrollPlan> plans;		// Loops chosen to unroll
+
+/****************
+ * Sets the largest size an unrolled loop may reach. 0 turns
+ * unrolling off.
+ */
+void setUnrollBudget(int budget)
+{
+  unrollBudget = budget;
+}
+
+/****************
+ * Sets the most copies of a body kept inside a partly unrolled
+ * loop. 1 allows full unrolling only.
+ */
+void setUnrollFactor(int factor)
+{
+  unrollFactor = factor;
+}
+
+/****************
+ * Auxiliary function for unrolling. Takes the root of a simplified
+ * tree and decides how every loop in it is generated.
+ */
+void planUnroll(Node* root)
+{
+  entries.clear();
+  plans.clear();
+  if(unrollBudget <= 0)
+  {
+    return;
+  }
+  map<string, int> vals;
+  findDeclared(root, vals);
+  knownStep(root, vals);
+  planSize(root);
+}
+
+/****************
+ * True if a loop was chosen to unroll, setting how many times the
+ * body runs in total and how many copies of it run between tests.
+ */
+bool getUnroll(Node* node, int &trips, int &copies)
+{
+  map<Node*, unrollPlan>::iterator it = plans.find(node);
+  if(it == plans.end())
+  {
+    return false;
+  }
+  trips = it->second.trips;
+  copies = it->second.copies;
+  return true;
+}
+
+/****************
+ * Every declared variable starts with its value, the first
+ * declaration of a name wins as it does in codeGen.cpp.
+ */
+void findDeclared(Node* node, map<string, int> &vals)
+{
+  if(!node)
+  {
+    return;
+  }
+  if(node->label.compare("vars") == 0)
+  {
+    int num;
+    stringstream value(node->token2.tokenString);
+    value >> num;
+    vals.insert(pair<string, int>(node->token1.tokenString, num));
+  }
+  findDeclared(node->child1, vals);
+  findDeclared(node->child2, vals);
+  findDeclared(node->child3, vals);
+  findDeclared(node->child4, vals);
+}
+
+/****************
+ * Updates vals with the variables known to hold an integer after
+ * a statement runs. Records the values known before every loop.
+ */
+void knownStep(Node* node, map<string, int> &vals)
+{
+  if(!node)
+  {
+    return;
+  }
+  string label = node->label;
+  if(label.compare("in") == 0)
+  {
+    vals.erase(node->token1.tokenString);
+  }
+  else if(label.compare("assign") == 0)
+  {
+    int num;
+    if(knownExpr(node->child1, vals, num))
+    {
+      vals[node->token1.tokenString] = num;
+    }
+    else
+    {
+      vals.erase(node->token1.tokenString);
+    }
+  }
+  // A goto from anywhere may land here.
+  else if(label.compare("label") == 0)
+  {
+    vals.clear();
+  }
+  // The statement may or may not run.
+  else if(label.compare("iffy") == 0)
+  {
+    map<string, int> body = vals;
+    knownStep(node->child4, body);
+    meetKnown(vals, body);
+  }
+  // The top of the loop is reached from before it and from the end
+  // of the body, only keep what holds for both. Knowing less at the
+  // top never gives more after the body, so this settles.
+  else if(label.compare("loop") == 0)
+  {
+    entries[node] = vals;
+    map<string, int> head = vals;
+    while(true)
+    {
+      map<string, int> body = head;
+      knownStep(node->child4, body);
+      map<string, int> next = head;
+      meetKnown(next, body);
+      if(next.size() == head.size())
+      {
+        break;
+      }
+      head = next;
+    }
+    vals = head;
+  }
+  else if(label.compare("vars") != 0 && label.compare("goto") != 0
+          && label.compare("out") != 0)
+  {
+    knownStep(node->child1, vals);
+    knownStep(node->child2, vals);
+    knownStep(node->child3, vals);
+    knownStep(node->child4, vals);
+  }
+}
+
+/****************
+ * True if an expression only uses integers and known variables,
+ * setting num to its value. Division by zero is never known.
+ */
+bool knownExpr(Node* node, map<string, int> &vals, int &num)
+{
+  exprType type = getType(node);
+  if(type == LEAF_ex)
+  {
+    if(getConst(node, num))
+    {
+      return true;
+    }
+    map<string, int>::iterator it = vals.find(node->token1.tokenString);
+    if(it == vals.end())
+    {
+      return false;
+    }
+    num = it->second;
+    return true;
+  }
+  if(type == PASS_ex)
+  {
+    return knownExpr(node->child1, vals, num);
+  }
+  int left, right;
+  if(type == NEG_ex)
+  {
+    return knownExpr(node->child1, vals, right) && canFold(SUB_ex, 0, right, num);
+  }
+  return knownExpr(node->child1, vals, left) && knownExpr(node->child2, vals, right)
+      && canFold(type, left, right, num);
+}
+
+/****************
+ * Keeps only the variables both paths agree on in into.
+ */
+void meetKnown(map<string, int> &into, map<string, int> &other)
+{
+  map<string, int>::iterator it = into.begin();
+  while(it != into.end())
+  {
+    map<string, int>::iterator match = other.find(it->first);
+    if(match == other.end() || match->second != it->second)
+    {
+      into.erase(it++);
+    }
+    else
+    {
+      it++;
+    }
+  }
+}
+
+/****************
+ * Returns the size of a subtree once its loops are unrolled,
+ * deciding loops from the innermost out so a body's size already
+ * includes any loops unrolled inside it.
+ */
+int planSize(Node* node)
+{
+  if(!node)
+  {
+    return 0;
+  }
+  if(node->label.compare("loop") != 0)
+  {
+    return (node->token1.tokenString.empty() ? 0 : 1) + planSize(node->child1)
+         + planSize(node->child2) + planSize(node->child3) + planSize(node->child4);
+  }
+
+  int body = planSize(node->child4);
+  int size = planSize(node->child1) + planSize(node->child2)
+           + planSize(node->child3) + body;
+  int trips;
+  string reason;
+  stringstream text;
+  if(!findTrips(node, trips, reason))
+  {
+    remark(lineOf(node->child1), "loop not unrolled, " + reason);
+    return size;
+  }
+
+  unrollPlan plan;
+  plan.trips = trips;
+  plan.copies = -1;
+  if(body * (long)trips <= unrollBudget)
+  {
+    plan.copies = trips;
+    size = body * trips;
+    text << "loop fully unrolled, " << trips << " iterations";
+  }
+  else
+  {
+    // Leftover iterations are copied before the loop too.
+    for(int copies = unrollFactor; copies >= 2 && plan.copies < 0; copies--)
+    {
+      if(copies < trips && body * (copies + trips % copies) <= unrollBudget)
+      {
+        plan.copies = copies;
+        size += body * (copies - 1 + trips % copies);
+        text << "loop unrolled " << copies << " times, " << trips << " iterations";
+      }
+    }
+  }
+
+  if(plan.copies < 0)
+  {
+    text << "loop not unrolled, body too large for " << trips << " iterations";
+  }
+  else
+  {
+    plans[node] = plan;
+  }
+  remark(lineOf(node->child1), text.str());
+  return size;
+}
+
+/****************
+ * Finds how many times a loop body runs. Returns false with the
+ * reason if the loop does not qualify or runs too long.
+ * The test subtracts the second expression from the first and
+ * checks the result, so it is repeated here the same way.
+ */
+bool findTrips(Node* node, int &trips, string &reason)
+{
+  if(entries.find(node) == entries.end())
+  {
+    reason = "never reached";
+    return false;
+  }
+  if(hasLabel(node->child4))
+  {
+    reason = "body has a label";
+    return false;
+  }
+
+  // One side is the stepped variable, the other cannot change.
+  map<string, int> &vals = entries[node];
+  string var, name;
+  int bound;
+  bool first = isIdent(node->child1, var);
+  Node* other = first ? node->child3 : node->child1;
+  if(!first && !isIdent(node->child3, var))
+  {
+    reason = "condition has no variable to count with";
+    return false;
+  }
+  bool fixed = getConst(other, bound)
+            || (isIdent(other, name) && countWrites(node->child4, name) == 0
+                && vals.find(name) != vals.end());
+  if(!fixed)
+  {
+    reason = "condition does not compare " + var + " with a constant";
+    return false;
+  }
+  if(!getConst(other, bound))
+  {
+    bound = vals[name];
+  }
+
+  int step;
+  if(!findStep(node->child4, var, step))
+  {
+    reason = "no single step '" + var + " := " + var + " + c' in the body";
+    return false;
+  }
+  if(vals.find(var) == vals.end())
+  {
+    reason = "value of " + var + " not known before the loop";
+    return false;
+  }
+
+  relType rel = getRel(node->child2);
+  int value = vals[var];
+  for(trips = 0; trips <= MAX_TRIPS; trips++)
+  {
+    int diff;
+    canFold(SUB_ex, first ? value : bound, first ? bound : value, diff);
+    bool holds;
+    switch(rel)
+    {
+    case LESS_rel:
+      holds = diff < 0;
+      break;
+    case LESSEQ_rel:
+      holds = diff <= 0;
+      break;
+    case GREATER_rel:
+      holds = diff > 0;
+      break;
+    case GREATEREQ_rel:
+      holds = diff >= 0;
+      break;
+    case NOTEQUAL_rel:
+      holds = diff != 0;
+      break;
+    default:
+      holds = diff == 0;
+    }
+    if(!holds)
+    {
+      return true;
+    }
+    canFold(ADD_ex, value, step, value);
+  }
+  reason = "runs too many iterations";
+  return false;
+}
+
+/****************
+ * True if var is written only by one statement directly in the
+ * body adding or subtracting an integer, setting step to the
+ * amount added each iteration.
+ */
+bool findStep(Node* body, string var, int &step)
+{
+  if(countWrites(body, var) != 1)
+  {
+    return false;
+  }
+  vector<Node*> stats;
+  topStats(body, stats);
+  for(unsigned int i = 0; i < stats.size(); i++)
+  {
+    Node* stat = stats[i];
+    if(stat->label.compare("assign") != 0 || stat->token1.tokenString.compare(var) != 0)
+    {
+      continue;
+    }
+    Node* expr = stat->child1;
+    while(getType(expr) == PASS_ex)
+    {
+      expr = expr->child1;
+    }
+    exprType type = getType(expr);
+    string name;
+    if((type == ADD_ex || type == SUB_ex) && isIdent(expr->child1, name)
+       && name.compare(var) == 0 && getConst(expr->child2, step))
+    {
+      return type == ADD_ex || canFold(SUB_ex, 0, step, step);
+    }
+  }
+  return false;
+}
+
+/****************
+ * Collects the statements run every time a <stat> runs, which is
+ * the statement itself or each statement directly in its block.
+ */
+void topStats(Node* node, vector<Node*> &stats)
+{
+  if(!node)
+  {
+    return;
+  }
+  if(node->label.compare("stat") == 0)
+  {
+    topStats(node->child1, stats);
+  }
+  else if(node->label.compare("block") == 0)
+  {
+    topStats(node->child2 ? node->child2 : node->child1, stats);
+  }
+  else if(node->label.compare("stats") == 0 || node->label.compare("mStat") == 0)
+  {
+    topStats(node->child1, stats);
+    topStats(node->child2, stats);
+  }
+  else if(node->label.compare("vars") != 0)
+  {
+    stats.push_back(node);
+  }
+}
+
+/****************
+ * True if an expression is a lone variable, setting name to it.
+ */
+bool isIdent(Node* node, string &name)
+{
+  while(getType(node) == PASS_ex)
+  {
+    node = node->child1;
+  }
+  if(getType(node) != LEAF_ex || node->token1.id != IDENT_tk)
+  {
+    return false;
+  }
+  name = node->token1.tokenString;
+  return true;
+}
+
+/****************
+ * Counts statements under a node that write var.
+ */
+int countWrites(Node* node, string var)
+{
+  if(!node)
+  {
+    return 0;
+  }
+  int count = 0;
+  if((node->label.compare("assign") == 0 || node->label.compare("in") == 0)
+     && node->token1.tokenString.compare(var) == 0)
+  {
+    count++;
+  }
+  return count + countWrites(node->child1, var) + countWrites(node->child2, var)
+       + countWrites(node->child3, var) + countWrites(node->child4, var);
+}
+
+/****************
+ * Line of the first token under a node, for remarks.
+ */
+int lineOf(Node* node)
+{
+  if(!node)
+  {
+    return 0;
+  }
+  if(!node->token1.tokenString.empty())
+  {
+    return lineAt(node->token1.offset);
+  }
+  int line = lineOf(node->child1);
+  return line ? line : lineOf(node->child2);
+}
@@ -0,0 +1,42 @@
+/***********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Declares functions needed for unroll.cpp.
+ * Includes node.h to allow for Node and Node pointers.
+ */
+
+#ifndef UNROLL_H
+#define UNROLL_H
+
+#include "node.h"
+#include <string>
+#include <vector>
+#include <map>
+
+// How a loop is generated. copies bodies run between tests,
+// and copies equal to trips means no loop is left at all.
+struct unrollPlan
+{
+  int trips;
+  int copies;
+};
+
+void setUnrollBudget(int);
+void setUnrollFactor(int);
+void planUnroll(Node*);
+bool getUnroll(Node*, int &, int &);
+
+void findDeclared(Node*, std::map<std::string, int> &);
+void knownStep(Node*, std::map<std::string, int> &);
+bool knownExpr(Node*, std::map<std::string, int> &, int &);
+void meetKnown(std::map<std::string, int> &, std::map<std::string, int> &);
+int planSize(Node*);
+bool findTrips(Node*, int &, std::string &);
+bool findStep(Node*, std::string, int &);
+void topStats(Node*, std::vector<Node*> &);
+bool isIdent(Node*, std::string &);
+int countWrites(Node*, std::string);
+int lineOf(Node*);
+
+#endif
@@ -0,0 +1,310 @@
+/**********************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * A small simulator for the .asm code generated for VirtMach.
+ * Only the instructions used by codeGen.cpp are supported.
+ *
+ * Loading happens in two passes. The first splits each line into
+ * an optional label, an instruction, and its argument, or into
+ * a variable name and initial value after STOP. The second resolves
+ * every argument into a data index, a label target, or an integer.
+ * Code generation can skip the first pass and load its lines directly.
+ *
+ * Running returns the number of instructions executed, which
+ * gives a rough measure of how good the generated code is.
+ */
+
+#include "virtMach.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <stdlib.h>
+using namespace std;
+
+// Instruction names in the same order as opCode.
+static const int OP_NUM = 16;
+static string opNames[OP_NUM] = {"READ", "WRITE", "LOAD", "STORE", "ADD", "SUB",
+                                 "MULT", "DIV", "BR", "BRNEG", "BRZNEG", "BRPOS",
+                                 "BRZPOS", "BRZERO", "NOOP", "STOP"};
+
+/* Reads a complete .asm file into a program. Any error in
+ * the file is reported and ends the program.
+ */
+void loadProgram(istream &in, program &prog)
+{
+  vector<asmLine> lines;
+  map<string, int> data;
+  string line;
+
+  while(getline(in, line))
+  {
+    stringstream words(line);
+    string word;
+    if(!(words >> word))
+    {
+      continue;
+    }
+
+    // Labels end with a colon and share a line with an instruction.
+    asmLine next;
+    if(word[word.length() - 1] == ':')
+    {
+      next.label = word.substr(0, word.length() - 1);
+      if(!(words >> word))
+      {
+        vmError("Label without an instruction", next.label);
+      }
+    }
+
+    opCode op;
+    if(findOp(word, op))
+    {
+      next.op = word;
+      words >> next.arg;
+      lines.push_back(next);
+    }
+    // Anything else is a variable and its initial value.
+    else
+    {
+      string value;
+      if(!(words >> value))
+      {
+        vmError("Variable without an initial value", word);
+      }
+      data[word] = atoi(value.c_str());
+    }
+  }
+
+  loadLines(lines, data, prog);
+}
+
+/* Builds a program from lines and initial values already split
+ * apart, as code generation keeps them before writing .asm.
+ */
+void loadLines(const vector<asmLine> &lines, const map<string, int> &data, program &prog)
+{
+  map<string, int>::const_iterator it = data.begin();
+  while(it != data.end())
+  {
+    prog.data[findVar(prog, it->first)] = it->second;
+    it++;
+  }
+
+  for(unsigned int i = 0; i < lines.size(); i++)
+  {
+    const asmLine &line = lines[i];
+    if(!line.label.empty())
+    {
+      if(prog.labels.find(line.label) != prog.labels.end())
+      {
+        vmError("Label declared twice", line.label);
+      }
+      prog.labels.insert(pair<string, int>(line.label, i));
+    }
+    instr next;
+    if(!findOp(line.op, next.op))
+    {
+      vmError("Unknown instruction", line.op);
+    }
+    next.arg = 0;
+    next.immediate = false;
+    prog.code.push_back(next);
+    prog.lines.push_back(line.line);
+  }
+
+  // Every label is known now, so resolve the arguments.
+  for(unsigned int i = 0; i < prog.code.size(); i++)
+  {
+    instr &cur = prog.code[i];
+    string arg = lines[i].arg;
+    if(cur.op == STOP_op || cur.op == NOOP_op)
+    {
+      continue;
+    }
+    if(arg.empty())
+    {
+      vmError("Missing argument for", opNames[cur.op]);
+    }
+
+    if(cur.op >= BR_op && cur.op <= BRZERO_op)
+    {
+      map<string, int>::iterator it = prog.labels.find(arg);
+      if(it == prog.labels.end())
+      {
+        vmError("Undeclared label", arg);
+      }
+      cur.arg = it->second;
+    }
+    else if(isdigit(arg[0]) || arg[0] == '-')
+    {
+      cur.arg = atoi(arg.c_str());
+      cur.immediate = true;
+    }
+    else
+    {
+      cur.arg = findVar(prog, arg);
+    }
+  }
+
+  if(prog.code.empty() || prog.code.back().op != STOP_op)
+  {
+    vmError("Program does not end with", "STOP");
+  }
+}
+
+/* Executes a loaded program starting from its first instruction
+ * until STOP. READ takes integers from in and WRITE sends them to out.
+ * Returns the number of instructions executed.
+ */
+long runProgram(const program &prog, istream &in, ostream &out)
+{
+  long count = 0;
+  runResult result = execProgram(prog, &in, out, -1, count);
+  if(result == INPUT_run)
+  {
+    vmError("Unable to read input for", "READ");
+  }
+  else if(result == DIVIDE_run)
+  {
+    vmError("Division by zero", "DIV");
+  }
+  return count;
+}
+
+/* Executes a loaded program without ending on errors.
+ * A null in means no input is available, so the first READ
+ * stops the run. A negative budget allows any number of
+ * instructions. count is set to the instructions executed.
+ */
+runResult execProgram(const program &prog, istream *in, ostream &out, long budget, long &count)
+{
+  vector<int> data = prog.data;	// Keep the loaded program reusable
+  int acc = 0;
+  unsigned int pc = 0;
+  count = 0;
+
+  while(pc < prog.code.size())
+  {
+    if(budget >= 0 && count >= budget)
+    {
+      return BUDGET_run;
+    }
+    const instr &cur = prog.code[pc];
+    int value = cur.immediate ? cur.arg : 0;
+    if(!cur.immediate && cur.op >= LOAD_op && cur.op <= DIV_op)
+    {
+      value = data[cur.arg];
+    }
+    count++;
+    pc++;
+
+    switch(cur.op)
+    {
+    case READ_op:
+      if(!in || !(*in >> data[cur.arg]))
+      {
+        return INPUT_run;
+      }
+      break;
+    case WRITE_op:
+      out << (cur.immediate ? cur.arg : data[cur.arg]) << endl;
+      break;
+    case LOAD_op:
+      acc = value;
+      break;
+    case STORE_op:
+      data[cur.arg] = acc;
+      break;
+    case ADD_op:
+      acc += value;
+      break;
+    case SUB_op:
+      acc -= value;
+      break;
+    case MULT_op:
+      acc *= value;
+      break;
+    case DIV_op:
+      if(value == 0)
+      {
+        return DIVIDE_run;
+      }
+      acc /= value;
+      break;
+    case BR_op:
+      pc = cur.arg;
+      break;
+    case BRNEG_op:
+      pc = acc < 0 ? cur.arg : pc;
+      break;
+    case BRZNEG_op:
+      pc = acc <= 0 ? cur.arg : pc;
+      break;
+    case BRPOS_op:
+      pc = acc > 0 ? cur.arg : pc;
+      break;
+    case BRZPOS_op:
+      pc = acc >= 0 ? cur.arg : pc;
+      break;
+    case BRZERO_op:
+      pc = acc == 0 ? cur.arg : pc;
+      break;
+    case NOOP_op:
+      break;
+    case STOP_op:
+      return STOP_run;
+    }
+  }
+
+  return STOP_run;
+}
+
+/* Gives the name of an instruction as written in .asm.
+ */
+string opName(opCode op)
+{
+  return opNames[op];
+}
+
+/* Looks up an instruction name. Returns false if the word
+ * is not an instruction.
+ */
+bool findOp(string word, opCode &op)
+{
+  for(int i = 0; i < OP_NUM; i++)
+  {
+    if(opNames[i].compare(word) == 0)
+    {
+      op = static_cast<opCode>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Returns the data index of a variable, adding it with
+ * an initial value of 0 the first time it is seen.
+ */
+int findVar(program &prog, string name)
+{
+  map<string, int>::iterator it = prog.vars.find(name);
+  if(it != prog.vars.end())
+  {
+    return it->second;
+  }
+  prog.names.push_back(name);
+  prog.data.push_back(0);
+  prog.vars.insert(pair<string, int>(name, prog.names.size() - 1));
+  return prog.names.size() - 1;
+}
+
+/* Prints an error for the simulator and exits.
+ */
+void vmError(string reason, string context)
+{
+  cout << endl;
+  cout << "VM ERROR: " << reason << " '" << context << "'." << endl;
+  cout << endl;
+  exit(1);
+}
@@ -0,0 +1,56 @@
+/****************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Provides all needed functionality for virtMach.cpp.
+ * Instructions are stored already resolved, so variables
+ * and labels are indexes instead of strings.
+ */
+
+#ifndef VIRTMACH_H
+#define VIRTMACH_H
+
+#include "asmLine.h"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <map>
+
+typedef enum {READ_op, WRITE_op, LOAD_op, STORE_op, ADD_op, SUB_op,
+              MULT_op, DIV_op, BR_op, BRNEG_op, BRZNEG_op, BRPOS_op,
+              BRZPOS_op, BRZERO_op, NOOP_op, STOP_op} opCode;
+
+// How a run ended. Anything but STOP_run means the program
+// could not finish: it needed input that was not given, ran past
+// its instruction budget, or divided by zero.
+typedef enum {STOP_run, INPUT_run, BUDGET_run, DIVIDE_run} runResult;
+
+struct instr
+{
+  opCode op;
+  int arg;		// Data index, branch target, or integer value
+  bool immediate;	// True when arg is an integer value
+};
+
+struct program
+{
+  std::vector<instr> code;
+  std::vector<int> data;		// Initial value of every variable
+  std::vector<std::string> names;	// Variable name of every data index
+  std::vector<int> lines;		// Source line of every instruction, 0 if unknown
+  std::map<std::string, int> vars;	// Variable name to data index
+  std::map<std::string, int> labels;	// Label name to instruction index
+};
+
+void loadProgram(std::istream &, program &);
+void loadLines(const std::vector<asmLine> &, const std::map<std::string, int> &, program &);
+long runProgram(const program &, std::istream &, std::ostream &);
+runResult execProgram(const program &, std::istream *, std::ostream &, long, long &);
+
+bool findOp(std::string, opCode &);
+std::string opName(opCode);
+int findVar(program &, std::string);
+void vmError(std::string, std::string);
+
+#endif
@@ -0,0 +1,135 @@
+/*******************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Usage:
+ * vmconv [-s] input output
+ *
+ * Converts a program between .asm text and the binary form from
+ * comp --emit=bytecode. The form of input is found from its first
+ * bytes and output is written in the other one.
+ *
+ * With -s, both files are loaded repeatedly afterwards and their
+ * sizes and average load times are printed, to compare the forms.
+ */
+
+#include "virtMach.h"
+#include "bytecode.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdlib.h>
+#include <sys/time.h>
+using namespace std;
+
+// Loads timed for each form with -s.
+static const int LOAD_RUNS = 1000;
+
+double timeLoads(string, bool);
+long fileSize(string);
+
+int main(int argc, char *argv[])
+{
+  bool compare = false;
+  string files[2];
+  int count = 0;
+
+  for(int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if(arg.compare("-s") == 0)
+    {
+      compare = true;
+    }
+    else if(count < 2)
+    {
+      files[count++] = arg;
+    }
+    else
+    {
+      count++;
+    }
+  }
+  if(count != 2)
+  {
+    cout << "usage: vmconv [-s] input output\n";
+    exit(1);
+  }
+
+  bool binary = isBytecode(files[0]);
+  program prog;
+  if(binary)
+  {
+    loadBytecode(files[0], prog);
+  }
+  else
+  {
+    ifstream in(files[0].c_str());
+    if(!in.is_open())
+    {
+      cout << "Unable to open file " << files[0] << endl;
+      exit(1);
+    }
+    loadProgram(in, prog);
+  }
+
+  ofstream out(files[1].c_str(), binary ? ios::out : ios::binary);
+  if(!out.is_open())
+  {
+    cout << "Unable to write to " << files[1] << ".\n";
+    exit(1);
+  }
+  if(binary)
+  {
+    writeText(out, prog);
+  }
+  else
+  {
+    writeBytecode(out, prog);
+  }
+  out.close();
+
+  if(compare)
+  {
+    string text = binary ? files[1] : files[0];
+    string bytes = binary ? files[0] : files[1];
+    cout << "text:     " << fileSize(text) << " bytes, "
+         << timeLoads(text, false) << " us per load\n";
+    cout << "bytecode: " << fileSize(bytes) << " bytes, "
+         << timeLoads(bytes, true) << " us per load\n";
+  }
+
+  return 0;
+}
+
+/* Average microseconds to load a file, including opening it.
+ */
+double timeLoads(string filename, bool binary)
+{
+  timeval start, end;
+  gettimeofday(&start, NULL);
+  for(int i = 0; i < LOAD_RUNS; i++)
+  {
+    program prog;
+    if(binary)
+    {
+      loadBytecode(filename, prog);
+    }
+    else
+    {
+      ifstream in(filename.c_str());
+      loadProgram(in, prog);
+    }
+  }
+  gettimeofday(&end, NULL);
+  double total = (end.tv_sec - start.tv_sec) * 1000000.0 + (end.tv_usec - start.tv_usec);
+  return total / LOAD_RUNS;
+}
+
+/* Size of a file in bytes.
+ */
+long fileSize(string filename)
+{
+  ifstream file(filename.c_str(), ios::binary | ios::ate);
+  return file.tellg();
+}
@@ -0,0 +1,223 @@
+/*******************************
+ * Author: John Soderstrom
+ * Due Date: 5/14/2020
+ *
+ * Usage:
+ * vmsim [-c] [-f | -j | -p | -b records] file
+ *
+ * Runs a .asm file generated by comp without needing VirtMach.
+ * Values for READ come from stdin and WRITE goes to stdout.
+ * Files written with comp --emit=bytecode are recognized by their
+ * first bytes and mapped in directly, see bytecode.cpp.
+ *
+ * With -c, the number of executed instructions is printed after
+ * the program stops. This is used to compare generated code
+ * before and after changes to codeGen.cpp.
+ *
+ * With -j, the program is compiled to machine code by jit.cpp and
+ * run natively instead of interpreted. Output is the same, but no
+ * instructions are counted, so -c cannot be combined with it.
+ *
+ * With -p, the program runs in the profiler from profile.cpp and a
+ * report of the hottest instructions, labels, and source lines is
+ * printed to stderr. Source lines are read from file.map, written by
+ * comp --line-map, when it is there.
+ *
+ * With -f, the program runs in the engine from fuse.cpp, which
+ * executes common sequences as single superinstructions. Adding -c
+ * prints which ones were formed and how often each was dispatched.
+ *
+ * With -b, the program runs once for every line of the records
+ * file, using that line as its input, and writes one line of output
+ * per record. Records run eight at a time in the AVX2 lanes of
+ * batch.cpp. Adding -c prints the throughput in records per second.
+ */
+
+#include "virtMach.h"
+#include "bytecode.h"
+#include "jit.h"
+#include "profile.h"
+#include "fuse.h"
+#include "batch.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <sys/time.h>
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+  bool countOnly = false;
+  bool native = false;
+  bool profile = false;
+  bool fusing = false;
+  string batch = "";
+  string filename = "";
+
+  for(int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if(arg.compare("-c") == 0)
+    {
+      countOnly = true;
+    }
+    else if(arg.compare("-j") == 0)
+    {
+      native = true;
+    }
+    else if(arg.compare("-p") == 0)
+    {
+      profile = true;
+    }
+    else if(arg.compare("-f") == 0)
+    {
+      fusing = true;
+    }
+    else if(arg.compare("-b") == 0 && i + 1 < argc)
+    {
+      batch = argv[++i];
+    }
+    else if(filename.empty())
+    {
+      filename = arg;
+    }
+    else
+    {
+      cout << "Error: Unexpected number of arguments.\n";
+      cout << "usage: vmsim [-c] [-f | -j | -p | -b records] file\n";
+      exit(1);
+    }
+  }
+
+  if(filename.empty() || (native && countOnly) || native + profile + fusing + !batch.empty() > 1)
+  {
+    cout << "usage: vmsim [-c] [-f | -j | -p | -b records] file\n";
+    exit(1);
+  }
+
+  // Allow the implicit extensions like comp does.
+  ifstream asmFile(filename.c_str());
+  string extensions[2] = {".asm", ".vmb"};
+  for(int i = 0; i < 2 && !asmFile.is_open(); i++)
+  {
+    asmFile.open((filename + extensions[i]).c_str());
+    if(asmFile.is_open())
+    {
+      filename += extensions[i];
+    }
+  }
+  if(!asmFile.is_open())
+  {
+    cout << "Unable to open file " << filename << endl;
+    exit(1);
+  }
+
+  program prog;
+  if(isBytecode(filename))
+  {
+    loadBytecode(filename, prog);
+  }
+  else
+  {
+    loadProgram(asmFile, prog);
+  }
+
+  if(native)
+  {
+    if(!jitSupported())
+    {
+      cout << "Error: -j needs an x86-64 host, run without it instead.\n";
+      exit(1);
+    }
+    runResult result;
+    if(!jitProgram(prog, &cin, cout, result))
+    {
+      vmError("Unable to get executable memory for", filename);
+    }
+    if(result == INPUT_run)
+    {
+      vmError("Unable to read input for", "READ");
+    }
+    else if(result == DIVIDE_run)
+    {
+      vmError("Division by zero", "DIV");
+    }
+    return 0;
+  }
+
+  if(profile)
+  {
+    bool haveLines = loadLineMap(filename.substr(0, filename.rfind('.')) + ".map", prog);
+    vector<long> counts;
+    runResult result = profileProgram(prog, &cin, cout, counts);
+    if(result == INPUT_run)
+    {
+      vmError("Unable to read input for", "READ");
+    }
+    else if(result == DIVIDE_run)
+    {
+      vmError("Division by zero", "DIV");
+    }
+    printProfile(cerr, prog, counts, haveLines);
+    return 0;
+  }
+
+  if(!batch.empty())
+  {
+    ifstream recordFile(batch.c_str());
+    if(!recordFile.is_open())
+    {
+      cout << "Unable to open file " << batch << endl;
+      exit(1);
+    }
+    vector<vector<int> > records;
+    loadRecords(recordFile, records);
+    batchStats stats;
+    timeval start, end;
+    gettimeofday(&start, NULL);
+    runBatch(prog, records, cout, stats);
+    gettimeofday(&end, NULL);
+    if(countOnly)
+    {
+      double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+      cerr << filename << ": " << stats.records << " records in " << seconds << " s, "
+           << (long)(stats.records / seconds) << " records/s, "
+           << (stats.simd ? "AVX2" : "scalar") << " lanes "
+           << 100 * stats.lanes / (stats.steps * BATCH_LANES + 1) << "% busy\n";
+    }
+    return 0;
+  }
+
+  if(fusing)
+  {
+    fusedProgram fused;
+    fuseProgram(prog, fused);
+    vector<long> counts;
+    runResult result = runFused(fused, &cin, cout, counts);
+    if(result == INPUT_run)
+    {
+      vmError("Unable to read input for", "READ");
+    }
+    else if(result == DIVIDE_run)
+    {
+      vmError("Division by zero", "DIV");
+    }
+    if(countOnly)
+    {
+      cerr << filename << ": ";
+      printFusions(cerr, fused, counts);
+    }
+    return 0;
+  }
+
+  long count = runProgram(prog, cin, cout);
+
+  if(countOnly)
+  {
+    cerr << filename << ": " << count << " instructions executed\n";
+  }
+
+  return 0;
+}